@@ -0,0 +1,768 @@
+// Headless behaviour checks. Each one compares an optimized path against a
+// plain reference, or checks an invariant the optimization relies on:
+//
+//  - rne_reorder() only swaps commands that don't overlap and keeps the
+//    scissor of every command.
+//  - Ear clipping covers exactly the area of the polygon, with every triangle
+//    wound the same way.
+//  - rne_utf8_decode() rejects malformed, overlong and truncated sequences.
+//  - Tessellating with a cache produces the same batches as without.
+//  - Merged parallel jobs produce the same batch as rne_tessellate().
+//  - Atlas pages evicted to stay within a budget never hand out overlapping
+//    glyphs within a frame.
+//
+// Returns non-zero if any check fails.
+
+#include "rune/rune.h"
+#include "rune/rune_font.h"
+#include "rune/rune_tessellation.h"
+#include "spire.h"
+
+#include "font_data.h"
+
+#include <math.h>
+#include <string.h>
+
+static u32 random_next(u32* state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+static f32 random_range(u32* state, f32 min, f32 max) {
+    return min + (max - min) * (random_next(state) & 0xffff) / 65535.0f;
+}
+
+// -- Atlas callbacks ----------------------------------------------------------
+
+typedef struct AtlasCounters AtlasCounters;
+struct AtlasCounters {
+    u64 next_id;
+    u32 live_textures;
+    u32 updates;
+};
+
+static AtlasCounters atlas_counters;
+
+static RNE_UserData atlas_create(SP_Ivec2 size) {
+    (void) size;
+    atlas_counters.next_id++;
+    atlas_counters.live_textures++;
+    return (RNE_UserData) {
+        .id = atlas_counters.next_id,
+    };
+}
+
+static void atlas_destroy(RNE_UserData userdata) {
+    (void) userdata;
+    atlas_counters.live_textures--;
+}
+
+static void atlas_update(RNE_UserData userdata, SP_Ivec2 pos, SP_Ivec2 size, u32 stride, const u8* pixels) {
+    (void) userdata;
+    (void) pos;
+    (void) size;
+    (void) stride;
+    (void) pixels;
+    atlas_counters.updates++;
+}
+
+static const RNE_FontCallbacks atlas_callbacks = {
+    .create = atlas_create,
+    .destroy = atlas_destroy,
+    .update = atlas_update,
+};
+
+// -- Batch comparison ---------------------------------------------------------
+
+typedef struct BatchBuffers BatchBuffers;
+struct BatchBuffers {
+    RNE_Vertex vertices[16384];
+    u32 indices[49152];
+    RNE_Instance instances[1024];
+    RNE_Handle textures[8];
+};
+
+static BatchBuffers buffers_a;
+static BatchBuffers buffers_b;
+
+static RNE_TessellationConfig batch_config(SP_Arena* arena,
+        RNE_FontInterface font,
+        BatchBuffers* buffers,
+        u32 vertex_capacity,
+        b8 instanced) {
+    return (RNE_TessellationConfig) {
+        .arena = arena,
+        .font = font,
+        .vertex_buffer = buffers->vertices,
+        .vertex_capacity = vertex_capacity,
+        .index_buffer = buffers->indices,
+        .index_type = RNE_INDEX_TYPE_U32,
+        .index_capacity = vertex_capacity * 3,
+        .instance_buffer = instanced ? buffers->instances : NULL,
+        .instance_capacity = sp_arrlen(buffers->instances),
+        .texture_buffer = buffers->textures,
+        .texture_capacity = sp_arrlen(buffers->textures),
+        .null_texture = {.id = 1},
+    };
+}
+
+static b8 batch_equal(RNE_BatchCmd a, const BatchBuffers* buffers_a, RNE_BatchCmd b, const BatchBuffers* buffers_b) {
+    if (a.vertex_count != b.vertex_count ||
+            a.index_count != b.index_count ||
+            a.instance_count != b.instance_count ||
+            a.texture_count != b.texture_count) {
+        return false;
+    }
+    if (memcmp(buffers_a->vertices, buffers_b->vertices, sizeof(RNE_Vertex) * a.vertex_count) != 0 ||
+            memcmp(buffers_a->indices, buffers_b->indices, sizeof(u32) * a.index_count) != 0 ||
+            memcmp(buffers_a->instances, buffers_b->instances, sizeof(RNE_Instance) * a.instance_count) != 0 ||
+            memcmp(buffers_a->textures, buffers_b->textures, sizeof(RNE_Handle) * a.texture_count) != 0) {
+        return false;
+    }
+
+    RNE_RenderCmd* cmd_a = a.render_cmds;
+    RNE_RenderCmd* cmd_b = b.render_cmds;
+    for (; cmd_a != NULL && cmd_b != NULL; cmd_a = cmd_a->next, cmd_b = cmd_b->next) {
+        if (cmd_a->type != cmd_b->type ||
+                cmd_a->start_offset_bytes != cmd_b->start_offset_bytes ||
+                cmd_a->index_count != cmd_b->index_count ||
+                cmd_a->first_instance != cmd_b->first_instance ||
+                cmd_a->instance_count != cmd_b->instance_count ||
+                memcmp(&cmd_a->scissor, &cmd_b->scissor, sizeof(RNE_DrawScissor)) != 0) {
+            return false;
+        }
+    }
+    return cmd_a == NULL && cmd_b == NULL;
+}
+
+static void draw_scene(RNE_DrawCmdBuffer* buffer, RNE_Handle font_handle, u32 seed, u32 frame) {
+    u32 random = seed;
+    for (u32 i = 0; i < 300; i++) {
+        SP_Vec2 pos = sp_v2(random_range(&random, 0.0f, 600.0f), random_range(&random, 0.0f, 400.0f));
+        SP_Color color = {random_range(&random, 0.0f, 1.0f), 1.0f, 1.0f, 1.0f};
+        // Some commands change every frame, the rest stay cacheable.
+        if (i % 10 == 0) {
+            pos.x += frame;
+        }
+        switch (random_next(&random) % 8) {
+            case 0:
+                rne_draw_rect_filled(buffer, (RNE_DrawRect) {
+                        .pos = pos,
+                        .size = sp_v2(24.0f, 12.0f),
+                        .corner_radius = sp_v4s(4.0f),
+                        .corner_segments = 4,
+                        .color = color,
+                    });
+                break;
+            case 1:
+                rne_draw_rect_stroke(buffer, (RNE_DrawRect) {
+                        .pos = pos,
+                        .size = sp_v2(24.0f, 12.0f),
+                        .color = color,
+                    }, 2.0f);
+                break;
+            case 2:
+                rne_draw_circle_filled(buffer, (RNE_DrawCircle) {
+                        .pos = pos,
+                        .radius = 8.0f,
+                        .segments = 16,
+                        .color = color,
+                    });
+                break;
+            case 3:
+                rne_draw_image(buffer, (RNE_DrawImage) {
+                        .pos = pos,
+                        .size = sp_v2s(10.0f),
+                        .uv = {sp_v2s(0.0f), sp_v2s(1.0f)},
+                        .texture_handle = {.id = 2 + random_next(&random) % 3},
+                        .color = color,
+                    });
+                break;
+            case 4:
+                rne_draw_text(buffer, (RNE_DrawText) {
+                        .text = sp_str_lit("Rune AV"),
+                        .pos = pos,
+                        .color = color,
+                        .font_handle = font_handle,
+                        .font_size = 12.0f + random_next(&random) % 2 * 4.0f,
+                    });
+                break;
+            case 5: {
+                SP_Vec2 points[5] = {
+                    pos,
+                    sp_v2_add(pos, sp_v2(20.0f, 0.0f)),
+                    sp_v2_add(pos, sp_v2(10.0f, 5.0f)),
+                    sp_v2_add(pos, sp_v2(20.0f, 20.0f)),
+                    sp_v2_add(pos, sp_v2(0.0f, 20.0f)),
+                };
+                rne_draw_polygon_filled(buffer, (RNE_DrawPolygon) {
+                        .points = points,
+                        .point_count = sp_arrlen(points),
+                        .color = color,
+                    });
+            } break;
+            case 6:
+                rne_draw_line(buffer, (RNE_DrawLine) {
+                        .a = pos,
+                        .b = sp_v2_add(pos, sp_v2(30.0f, 3.0f)),
+                        .thickness = 3.0f,
+                        .color = color,
+                    });
+                break;
+            case 7: {
+                f32 inset = random_next(&random) % 3;
+                rne_draw_scissor(buffer, (RNE_DrawScissor) {
+                        .pos = sp_v2s(inset),
+                        .size = sp_v2s(800.0f),
+                    });
+            } break;
+        }
+    }
+}
+
+// -- Reorder ------------------------------------------------------------------
+
+typedef struct Rect Rect;
+struct Rect {
+    SP_Vec2 min;
+    SP_Vec2 max;
+};
+
+static Rect rect_union(Rect a, Rect b) {
+    return (Rect) {
+        .min = sp_v2(sp_min(a.min.x, b.min.x), sp_min(a.min.y, b.min.y)),
+        .max = sp_v2(sp_max(a.max.x, b.max.x), sp_max(a.max.y, b.max.y)),
+    };
+}
+
+static Rect rect_intersect(Rect a, Rect b) {
+    return (Rect) {
+        .min = sp_v2(sp_max(a.min.x, b.min.x), sp_max(a.min.y, b.min.y)),
+        .max = sp_v2(sp_min(a.max.x, b.max.x), sp_min(a.max.y, b.max.y)),
+    };
+}
+
+static b8 rect_overlap(Rect a, Rect b) {
+    return a.min.x < b.max.x && b.min.x < a.max.x &&
+        a.min.y < b.max.y && b.min.y < a.max.y;
+}
+
+// Area a command covers. Text covers the quads its glyphs are drawn with.
+static Rect covered_rect(const RNE_DrawCmd* cmd) {
+    switch (cmd->type) {
+        case RNE_DRAW_CMD_TYPE_RECT:
+            return (Rect) {cmd->data.rect.pos, sp_v2_add(cmd->data.rect.pos, cmd->data.rect.size)};
+        case RNE_DRAW_CMD_TYPE_IMAGE:
+            return (Rect) {cmd->data.image.pos, sp_v2_add(cmd->data.image.pos, cmd->data.image.size)};
+        case RNE_DRAW_CMD_TYPE_TEXT: {
+            RNE_DrawText text = cmd->data.text;
+            RNE_Handle sized = rne_font_sized(text.font_handle, text.font_size);
+            SP_Vec2 positions[64];
+            RNE_Glyph glyphs[64];
+            sp_assert(text.text.len <= sp_arrlen(glyphs), "Text too long for the check.");
+            u32 count = rne_sized_font_layout_run(sized, text.text, positions, glyphs);
+            SP_Vec2 origin = sp_v2(text.pos.x, text.pos.y + rne_sized_font_get_metrics(sized).ascent);
+            Rect rect = {text.pos, text.pos};
+            for (u32 i = 0; i < count; i++) {
+                SP_Vec2 pos = sp_v2_add(sp_v2_add(origin, positions[i]), glyphs[i].offset);
+                pos = sp_v2(floorf(pos.x), floorf(pos.y));
+                rect = rect_union(rect, (Rect) {pos, sp_v2_add(pos, glyphs[i].size)});
+            }
+            return rect;
+        }
+        default:
+            sp_assert(false, "Unexpected command in the reorder check.");
+            return (Rect) {0};
+    }
+}
+
+typedef struct ReorderEntry ReorderEntry;
+struct ReorderEntry {
+    RNE_DrawCmd* cmd;
+    RNE_DrawScissor scissor;
+    Rect rect;
+    // Position after reordering.
+    u32 order;
+    b8 placed;
+};
+
+static u32 check_reorder(SP_Arena* arena, RNE_Handle font_handle) {
+    u32 failures = 0;
+    for (u32 seed = 1; seed <= 8; seed++) {
+        RNE_DrawCmdBuffer buffer = rne_draw_buffer_begin(arena);
+        u32 random = seed;
+        for (u32 i = 0; i < 400; i++) {
+            SP_Vec2 pos = sp_v2(random_range(&random, 0.0f, 400.0f), random_range(&random, 0.0f, 300.0f));
+            switch (random_next(&random) % 5) {
+                case 0:
+                case 1:
+                    rne_draw_rect_filled(&buffer, (RNE_DrawRect) {
+                            .pos = pos,
+                            .size = sp_v2(random_range(&random, 4.0f, 60.0f), random_range(&random, 4.0f, 60.0f)),
+                            .color = SP_COLOR_WHITE,
+                        });
+                    break;
+                case 2:
+                    rne_draw_image(&buffer, (RNE_DrawImage) {
+                            .pos = pos,
+                            .size = sp_v2s(16.0f),
+                            .uv = {sp_v2s(0.0f), sp_v2s(1.0f)},
+                            .texture_handle = {.id = 1 + random_next(&random) % 3},
+                            .color = SP_COLOR_WHITE,
+                        });
+                    break;
+                case 3:
+                    rne_draw_text(&buffer, (RNE_DrawText) {
+                            .text = sp_str_lit("Reorder"),
+                            .pos = pos,
+                            .color = SP_COLOR_WHITE,
+                            .font_handle = font_handle,
+                            .font_size = 16.0f,
+                        });
+                    break;
+                case 4: {
+                    u32 kind = random_next(&random) % 3;
+                    RNE_DrawScissor scissor = kind == 0 ? RNE_SCISSOR_NONE : (RNE_DrawScissor) {
+                        .pos = sp_v2(kind * 50.0f, 0.0f),
+                        .size = sp_v2s(200.0f),
+                    };
+                    rne_draw_scissor(&buffer, scissor);
+                } break;
+            }
+        }
+
+        SP_Scratch scratch = sp_scratch_begin(&arena, 1);
+        ReorderEntry* entries = sp_arena_push(scratch.arena, sizeof(ReorderEntry) * 400);
+        u32 entry_count = 0;
+        RNE_DrawScissor scissor = RNE_SCISSOR_NONE;
+        for (RNE_DrawCmd* cmd = buffer.first; cmd != NULL; cmd = cmd->next) {
+            if (cmd->type == RNE_DRAW_CMD_TYPE_SCISSOR) {
+                scissor = cmd->data.scissor;
+                continue;
+            }
+            entries[entry_count] = (ReorderEntry) {
+                .cmd = cmd,
+                .scissor = scissor,
+                .rect = rect_intersect(covered_rect(cmd),
+                        (Rect) {scissor.pos, sp_v2_add(scissor.pos, scissor.size)}),
+            };
+            entry_count++;
+        }
+
+        RNE_ReorderStats stats = rne_reorder(&buffer, RNE_FONT_INTERFACE, (RNE_Handle) {0});
+        if (stats.render_cmds_after > stats.render_cmds_before) {
+            sp_error("reorder: seed %u went from %u to %u render commands.",
+                    seed, stats.render_cmds_before, stats.render_cmds_after);
+            failures++;
+        }
+
+        // Every command must still be there once, under the same scissor.
+        u32 order = 0;
+        scissor = RNE_SCISSOR_NONE;
+        for (RNE_DrawCmd* cmd = buffer.first; cmd != NULL; cmd = cmd->next) {
+            if (cmd->type == RNE_DRAW_CMD_TYPE_SCISSOR) {
+                scissor = cmd->data.scissor;
+                continue;
+            }
+            ReorderEntry* entry = NULL;
+            for (u32 i = 0; i < entry_count; i++) {
+                if (entries[i].cmd == cmd) {
+                    entry = &entries[i];
+                    break;
+                }
+            }
+            if (entry == NULL || entry->placed ||
+                    memcmp(&entry->scissor, &scissor, sizeof(RNE_DrawScissor)) != 0) {
+                sp_error("reorder: seed %u lost, duplicated or rescissored a command.", seed);
+                failures++;
+                continue;
+            }
+            entry->order = order;
+            entry->placed = true;
+            order++;
+        }
+        if (order != entry_count) {
+            sp_error("reorder: seed %u has %u commands instead of %u.", seed, order, entry_count);
+            failures++;
+        }
+
+        // Commands that swapped places must not overlap.
+        for (u32 i = 0; i < entry_count; i++) {
+            for (u32 j = i + 1; j < entry_count; j++) {
+                if (entries[i].order > entries[j].order && rect_overlap(entries[i].rect, entries[j].rect)) {
+                    sp_error("reorder: seed %u swapped overlapping commands %u and %u.", seed, i, j);
+                    failures++;
+                }
+            }
+        }
+        sp_scratch_end(scratch);
+    }
+    return failures;
+}
+
+// -- Ear clipping -------------------------------------------------------------
+
+static f64 signed_area(const SP_Vec2* points, u32 count) {
+    f64 area = 0.0;
+    for (u32 i = 0; i < count; i++) {
+        SP_Vec2 a = points[i];
+        SP_Vec2 b = points[(i + 1) % count];
+        area += (f64) a.x * b.y - (f64) b.x * a.y;
+    }
+    return area / 2.0;
+}
+
+static u32 check_polygon(SP_Arena* arena, RNE_FontInterface font, const char* name, const SP_Vec2* points, u32 count) {
+    RNE_DrawCmdBuffer buffer = rne_draw_buffer_begin(arena);
+    rne_draw_polygon_filled(&buffer, (RNE_DrawPolygon) {
+            .points = points,
+            .point_count = count,
+            .color = SP_COLOR_WHITE,
+        });
+    RNE_TessellationState* state = NULL;
+    RNE_BatchCmd batch = rne_tessellate(&buffer,
+            batch_config(arena, font, &buffers_a, sp_arrlen(buffers_a.vertices), false),
+            &state);
+
+    f64 area = signed_area(points, count);
+    f64 triangle_sum = 0.0;
+    u32 flipped = 0;
+    for (u32 i = 0; i < batch.index_count; i += 3) {
+        SP_Vec2 triangle[3] = {
+            buffers_a.vertices[buffers_a.indices[i + 0]].pos,
+            buffers_a.vertices[buffers_a.indices[i + 1]].pos,
+            buffers_a.vertices[buffers_a.indices[i + 2]].pos,
+        };
+        f64 triangle_area = signed_area(triangle, 3);
+        triangle_sum += triangle_area;
+        if (triangle_area * area < -1e-6) {
+            flipped++;
+        }
+    }
+
+    if (batch.index_count != (count - 2) * 3 || flipped > 0 || fabs(triangle_sum - area) > fabs(area) * 1e-5) {
+        sp_error("ear clipping: %s has %u indices, %u flipped triangles and area %f instead of %f.",
+                name, batch.index_count, flipped, triangle_sum, area);
+        return 1;
+    }
+    return 0;
+}
+
+static u32 check_ear_clipping(SP_Arena* arena, RNE_FontInterface font) {
+    u32 failures = 0;
+    SP_Vec2 points[1024];
+
+    // Star, both windings.
+    for (u32 i = 0; i < 10; i++) {
+        f32 radius = i % 2 == 0 ? 100.0f : 40.0f;
+        f32 angle = i * 3.14159265f / 5.0f;
+        points[i] = sp_v2(cosf(angle) * radius, sinf(angle) * radius);
+    }
+    failures += check_polygon(arena, font, "star", points, 10);
+    for (u32 i = 0; i < 5; i++) {
+        SP_Vec2 swap = points[i];
+        points[i] = points[9 - i];
+        points[9 - i] = swap;
+    }
+    failures += check_polygon(arena, font, "reversed star", points, 10);
+
+    // Comb, one ear at a time between long reflex runs.
+    u32 count = 0;
+    for (u32 i = 0; i < 100; i++) {
+        points[count++] = sp_v2(i * 4.0f, 0.0f);
+        points[count++] = sp_v2(i * 4.0f + 2.0f, 100.0f);
+        points[count++] = sp_v2(i * 4.0f + 3.0f, 100.0f);
+    }
+    points[count++] = sp_v2(400.0f, -10.0f);
+    points[count++] = sp_v2(0.0f, -10.0f);
+    failures += check_polygon(arena, font, "comb", points, count);
+
+    // Spiral strip, almost every vertex on the inside is reflex.
+    count = 0;
+    for (u32 i = 0; i < 200; i++) {
+        f32 angle = i * 0.1f;
+        points[count++] = sp_v2(cosf(angle) * (50.0f + i), sinf(angle) * (50.0f + i));
+    }
+    for (u32 i = 200; i > 0; i--) {
+        f32 angle = (i - 1) * 0.1f;
+        points[count++] = sp_v2(cosf(angle) * (40.0f + i - 1), sinf(angle) * (40.0f + i - 1));
+    }
+    failures += check_polygon(arena, font, "spiral", points, count);
+
+    // Collinear points on an edge.
+    SP_Vec2 collinear[] = {
+        sp_v2(0.0f, 0.0f),
+        sp_v2(5.0f, 0.0f),
+        sp_v2(10.0f, 0.0f),
+        sp_v2(10.0f, 10.0f),
+        sp_v2(0.0f, 10.0f),
+    };
+    failures += check_polygon(arena, font, "collinear", collinear, sp_arrlen(collinear));
+    return failures;
+}
+
+// -- UTF-8 --------------------------------------------------------------------
+
+typedef struct Utf8Case Utf8Case;
+struct Utf8Case {
+    const char* name;
+    const char* bytes;
+    u32 codepoints[4];
+    u32 codepoint_count;
+};
+
+#define I RNE_CODEPOINT_INVALID
+
+static const Utf8Case utf8_cases[] = {
+    {"ascii", "A", {'A'}, 1},
+    {"two bytes", "\xc3\xa9", {0xe9}, 1},
+    {"three bytes", "\xe2\x82\xac", {0x20ac}, 1},
+    {"four bytes", "\xf0\x9f\x98\x80", {0x1f600}, 1},
+    {"largest codepoint", "\xf4\x8f\xbf\xbf", {0x10ffff}, 1},
+    {"overlong two bytes", "\xc0\xaf", {I, I}, 2},
+    {"overlong three bytes", "\xe0\x80\xaf", {I, I, I}, 3},
+    {"overlong four bytes", "\xf0\x80\x80\xaf", {I, I, I, I}, 4},
+    {"surrogate", "\xed\xa0\x80", {I, I, I}, 3},
+    {"past the Unicode range", "\xf4\x90\x80\x80", {I, I, I, I}, 4},
+    {"truncated", "\xe2\x82", {I, I}, 2},
+    {"bad continuation", "\xc3" "A", {I, 'A'}, 2},
+    {"lone continuation", "\x80" "A", {I, 'A'}, 2},
+    {"invalid lead", "\xff", {I}, 1},
+};
+
+#undef I
+
+static u32 check_utf8(void) {
+    u32 failures = 0;
+    for (u32 i = 0; i < sp_arrlen(utf8_cases); i++) {
+        Utf8Case test = utf8_cases[i];
+        SP_Str text = sp_str((const u8*) test.bytes, strlen(test.bytes));
+        u32 count = 0;
+        b8 ok = true;
+        for (u32 offset = 0; offset < text.len;) {
+            u32 codepoint = rne_utf8_decode(text, &offset);
+            if (count >= test.codepoint_count || codepoint != test.codepoints[count]) {
+                ok = false;
+            }
+            count++;
+        }
+        if (!ok || count != test.codepoint_count) {
+            sp_error("utf8: %s decoded wrong.", test.name);
+            failures++;
+        }
+    }
+    return failures;
+}
+
+// -- Tessellation cache -------------------------------------------------------
+
+static u32 check_cache(SP_Arena* arena, RNE_FontInterface font, RNE_Handle font_handle) {
+    u32 failures = 0;
+    // The small budget evicts constantly, the large one holds a whole frame.
+    u32 budgets[] = {16 * 1024, 4 * 1024 * 1024};
+    SP_Arena* frame_arena = sp_arena_create();
+    for (u32 budget = 0; budget < sp_arrlen(budgets); budget++) {
+        RNE_TessellationCache* cache = rne_tessellation_cache_create(arena, budgets[budget]);
+        for (u32 frame = 0; frame < 8; frame++) {
+            for (u32 anti_aliasing = 0; anti_aliasing < 2; anti_aliasing++) {
+                RNE_DrawCmdBuffer plain = rne_draw_buffer_begin(frame_arena);
+                RNE_DrawCmdBuffer cached = rne_draw_buffer_begin(frame_arena);
+                draw_scene(&plain, font_handle, 7, frame);
+                draw_scene(&cached, font_handle, 7, frame);
+
+                // Small buffers, so commands also get retried in a new batch.
+                RNE_TessellationConfig plain_config = batch_config(frame_arena, font, &buffers_a, 1024, false);
+                plain_config.anti_aliasing = anti_aliasing;
+                RNE_TessellationConfig cached_config = batch_config(frame_arena, font, &buffers_b, 1024, false);
+                cached_config.anti_aliasing = anti_aliasing;
+                cached_config.cache = cache;
+
+                RNE_TessellationState* plain_state = NULL;
+                RNE_TessellationState* cached_state = NULL;
+                while (true) {
+                    RNE_BatchCmd plain_batch = rne_tessellate(&plain, plain_config, &plain_state);
+                    RNE_BatchCmd cached_batch = rne_tessellate(&cached, cached_config, &cached_state);
+                    if (plain_batch.render_cmds == NULL || cached_batch.render_cmds == NULL) {
+                        if (plain_batch.render_cmds != cached_batch.render_cmds) {
+                            sp_error("cache: frame %u ended after a different number of batches.", frame);
+                            failures++;
+                        }
+                        break;
+                    }
+                    if (!batch_equal(plain_batch, &buffers_a, cached_batch, &buffers_b)) {
+                        sp_error("cache: frame %u produced a different batch.", frame);
+                        failures++;
+                    }
+                }
+                sp_arena_clear(frame_arena);
+            }
+        }
+
+        RNE_TessellationCacheStats stats = rne_tessellation_cache_stats(cache);
+        if (budget == 0 ? stats.evictions == 0 : stats.hits == 0) {
+            sp_error("cache: a budget of %u bytes never %s.", budgets[budget], budget == 0 ? "evicted" : "hit");
+            failures++;
+        }
+    }
+    return failures;
+}
+
+// -- Parallel tessellation ----------------------------------------------------
+
+static u32 check_parallel(SP_Arena* arena, RNE_FontInterface font, RNE_Handle font_handle) {
+    u32 failures = 0;
+    SP_Arena* job_arenas[8];
+    for (u32 i = 0; i < sp_arrlen(job_arenas); i++) {
+        job_arenas[i] = sp_arena_create();
+    }
+    for (u32 job_count = 1; job_count <= 8; job_count++) {
+        for (u32 mode = 0; mode < 4; mode++) {
+            b8 instanced = mode & 1;
+            b8 anti_aliasing = mode & 2;
+
+            SP_Scratch scratch = sp_scratch_begin(&arena, 1);
+            RNE_DrawCmdBuffer buffer = rne_draw_buffer_begin(scratch.arena);
+            draw_scene(&buffer, font_handle, job_count, 0);
+
+            RNE_TessellationConfig serial_config = batch_config(scratch.arena, font, &buffers_a, sp_arrlen(buffers_a.vertices), instanced);
+            serial_config.anti_aliasing = anti_aliasing;
+            RNE_TessellationConfig parallel_config = batch_config(scratch.arena, font, &buffers_b, sp_arrlen(buffers_b.vertices), instanced);
+            parallel_config.anti_aliasing = anti_aliasing;
+
+            RNE_TessellationJobs* jobs = rne_tessellate_split(&buffer, parallel_config, job_count);
+            // Jobs are independent, so running them backwards on one thread
+            // must give the same result as any threaded schedule.
+            u32 jobs_run = rne_tessellate_job_count(jobs);
+            for (u32 i = jobs_run; i > 0; i--) {
+                rne_tessellate_job_run(jobs, i - 1, job_arenas[i - 1]);
+            }
+            RNE_BatchCmd parallel_batch;
+            b8 merged = rne_tessellate_merge(jobs, &parallel_batch);
+
+            RNE_TessellationState* state = NULL;
+            RNE_BatchCmd serial_batch = rne_tessellate(&buffer, serial_config, &state);
+            if (!merged || !batch_equal(serial_batch, &buffers_a, parallel_batch, &buffers_b)) {
+                sp_error("parallel: %u jobs in mode %u don't match the serial batch.", job_count, mode);
+                failures++;
+            }
+
+            for (u32 i = 0; i < jobs_run; i++) {
+                sp_arena_clear(job_arenas[i]);
+            }
+            sp_scratch_end(scratch);
+        }
+    }
+    return failures;
+}
+
+// -- Atlas eviction -----------------------------------------------------------
+
+typedef struct HandedGlyph HandedGlyph;
+struct HandedGlyph {
+    u64 page;
+    SP_Vec2 min;
+    SP_Vec2 max;
+};
+
+static u32 check_atlas_eviction(SP_Arena* arena) {
+    u32 failures = 0;
+    atlas_counters = (AtlasCounters) {0};
+    RNE_Handle atlas = rne_font_atlas_create(arena, (RNE_FontAtlasConfig) {
+            .callbacks = atlas_callbacks,
+            .atlas_packer = RNE_ATLAS_PACKER_SKYLINE,
+            .budget_bytes = 256 * 256 * 2,
+        });
+    RNE_Handle font = rne_font_create(arena, ttf_data, (RNE_FontConfig) {
+            .shared_atlas = atlas,
+        });
+
+    static HandedGlyph handed[2 * 95];
+    for (u32 frame = 0; frame < 120; frame++) {
+        u32 handed_count = 0;
+        for (u32 k = 0; k < 2; k++) {
+            RNE_Handle sized = rne_font_sized(font, 8.0f + (frame * 2 + k) % 48);
+            for (u32 codepoint = 33; codepoint < 127; codepoint++) {
+                RNE_Glyph glyph = rne_sized_font_get_glyph(sized, codepoint);
+                if (glyph.size.x <= 0.0f || glyph.size.y <= 0.0f) {
+                    continue;
+                }
+                handed[handed_count] = (HandedGlyph) {
+                    .page = glyph.atlas.id,
+                    .min = glyph.uv[0],
+                    .max = glyph.uv[1],
+                };
+                handed_count++;
+            }
+        }
+
+        // Every glyph handed out this frame must still be where it says, so
+        // no two may overlap on the same page. Identical rects are the same
+        // glyph under two codepoints.
+        for (u32 i = 0; i < handed_count; i++) {
+            for (u32 j = i + 1; j < handed_count; j++) {
+                HandedGlyph a = handed[i];
+                HandedGlyph b = handed[j];
+                if (a.page != b.page ||
+                        memcmp(&a.min, &b.min, sizeof(SP_Vec2)) == 0) {
+                    continue;
+                }
+                if (a.min.x < b.max.x && b.min.x < a.max.x && a.min.y < b.max.y && b.min.y < a.max.y) {
+                    sp_error("atlas: frame %u handed out overlapping glyphs.", frame);
+                    failures++;
+                }
+            }
+        }
+
+        // Requesting them again within the frame must not rasterize anything.
+        u32 updates = atlas_counters.updates;
+        RNE_Handle sized = rne_font_sized(font, 8.0f + (frame * 2) % 48);
+        for (u32 codepoint = 33; codepoint < 127; codepoint++) {
+            rne_sized_font_get_glyph(sized, codepoint);
+        }
+        if (atlas_counters.updates != updates) {
+            sp_error("atlas: frame %u rasterized a glyph twice.", frame);
+            failures++;
+        }
+
+        rne_font_atlas_end_frame(atlas);
+    }
+
+    if (rne_font_atlas_stats(atlas).eviction_count == 0) {
+        sp_error("atlas: the budget never evicted a page.");
+        failures++;
+    }
+
+    rne_font_destroy(&font);
+    rne_font_atlas_destroy(&atlas);
+    if (atlas_counters.live_textures != 0) {
+        sp_error("atlas: %u textures leaked.", atlas_counters.live_textures);
+        failures++;
+    }
+    return failures;
+}
+
+i32 main(void) {
+    sp_init(SP_CONFIG_DEFAULT);
+    SP_Arena* arena = sp_arena_create();
+
+    // Text in the tessellation checks goes through the built-in font.
+    RNE_Handle font_atlas = rne_font_atlas_create(arena, (RNE_FontAtlasConfig) {
+            .callbacks = atlas_callbacks,
+            .atlas_packer = RNE_ATLAS_PACKER_SKYLINE,
+        });
+    RNE_Handle font_handle = rne_font_create(arena, ttf_data, (RNE_FontConfig) {
+            .shared_atlas = font_atlas,
+        });
+    RNE_FontInterface font = RNE_FONT_INTERFACE;
+
+    u32 reorder = check_reorder(arena, font_handle);
+    u32 ear_clipping = check_ear_clipping(arena, font);
+    u32 utf8 = check_utf8();
+    u32 cache = check_cache(arena, font, font_handle);
+    u32 parallel = check_parallel(arena, font, font_handle);
+    u32 atlas = check_atlas_eviction(arena);
+
+    sp_info("reorder: %u, ear clipping: %u, utf8: %u, cache: %u, parallel: %u, atlas: %u failures",
+            reorder, ear_clipping, utf8, cache, parallel, atlas);
+    return reorder + ear_clipping + utf8 + cache + parallel + atlas != 0;
+}
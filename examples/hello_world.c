@@ -80,27 +80,11 @@ void atlas_destroy(RNE_UserData userdata) {
     glDeleteTextures(1, &texture);
 }
 
-void atlas_resize(RNE_UserData userdata, SP_Ivec2 size, const u8* pixels) {
-    u32 texture = userdata.id;
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    glTexImage2D(GL_TEXTURE_2D,
-            0,
-            GL_R8,
-            size.x,
-            size.y,
-            0,
-            GL_RED,
-            GL_UNSIGNED_BYTE,
-            pixels);
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
-}
-
 void atlas_update(RNE_UserData userdata, SP_Ivec2 pos, SP_Ivec2 size, u32 stride, const u8* pixels) {
-    (void) stride;
     u32 texture = userdata.id;
     glBindTexture(GL_TEXTURE_2D, texture);
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, stride);
     glTexSubImage2D(GL_TEXTURE_2D,
             0,
             pos.x,
@@ -110,6 +94,7 @@ void atlas_update(RNE_UserData userdata, SP_Ivec2 pos, SP_Ivec2 size, u32 stride
             GL_RED,
             GL_UNSIGNED_BYTE,
             pixels);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
     glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 }
 
@@ -161,14 +146,20 @@ i32 main(void) {
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    RNE_FontCallbacks font_callbacks = {
-        .create = atlas_create,
-        .destroy = atlas_destroy,
-        .resize = atlas_resize,
-        .update = atlas_update,
+    // Shared by every size so all text lands on the same texture.
+    RNE_Handle font_atlas = rne_font_atlas_create(arena, (RNE_FontAtlasConfig) {
+            .callbacks = {
+                .create = atlas_create,
+                .destroy = atlas_destroy,
+                .update = atlas_update,
+            },
+            .atlas_packer = RNE_ATLAS_PACKER_SKYLINE,
+        });
+    RNE_FontConfig font_config = {
+        .shared_atlas = font_atlas,
     };
 
-    RNE_Handle font = rne_font_create(arena, ttf_data, font_callbacks);
+    RNE_Handle font = rne_font_create(arena, ttf_data, font_config);
 
     rne_init((RNE_StyleStack) {
             .size = {
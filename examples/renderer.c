@@ -25,6 +25,17 @@ Renderer renderer_create(void) {
     // Position
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(RNE_Vertex), (const void*) sp_offset(RNE_Vertex, pos));
     glEnableVertexAttribArray(0);
+#ifdef RUNE_COMPACT_VERTEX
+    // UV
+    glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(RNE_Vertex), (const void*) sp_offset(RNE_Vertex, uv));
+    glEnableVertexAttribArray(1);
+    // Color
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(RNE_Vertex), (const void*) sp_offset(RNE_Vertex, color));
+    glEnableVertexAttribArray(2);
+    // Texture index
+    glVertexAttribIPointer(3, 1, GL_UNSIGNED_BYTE, sizeof(RNE_Vertex), (const void*) sp_offset(RNE_Vertex, texture_index));
+    glEnableVertexAttribArray(3);
+#else
     // UV
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(RNE_Vertex), (const void*) sp_offset(RNE_Vertex, uv));
     glEnableVertexAttribArray(1);
@@ -34,6 +45,7 @@ Renderer renderer_create(void) {
     // Texture index
     glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, sizeof(RNE_Vertex), (const void*) sp_offset(RNE_Vertex, texture_index));
     glEnableVertexAttribArray(3);
+#endif
 
     glBindVertexArray(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
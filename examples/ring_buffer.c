@@ -0,0 +1,154 @@
+// Headless check of tessellating into ring buffers. A plain CPU allocation
+// stands in for a persistently mapped GPU buffer. Every batch written into the
+// ring is compared against the same batch tessellated into regular buffers.
+
+#include "rune/rune.h"
+#include "rune/rune_tessellation.h"
+#include "spire.h"
+
+#include <string.h>
+
+static RNE_Handle null_get_sized(RNE_Handle font, f32 size) {
+    (void) size;
+    return font;
+}
+
+static RNE_Glyph null_get_glyph(RNE_Handle sized_font, u32 codepoint) {
+    (void) sized_font;
+    (void) codepoint;
+    return (RNE_Glyph) {0};
+}
+
+static RNE_Handle null_get_atlas(RNE_Handle sized_font) {
+    return sized_font;
+}
+
+static RNE_FontMetrics null_get_metrics(RNE_Handle sized_font) {
+    (void) sized_font;
+    return (RNE_FontMetrics) {0};
+}
+
+// A real host would wait on the fence of the oldest frame still using the
+// ring here.
+static void fake_ring_wrap(RNE_RingBuffer* ring) {
+    u32* wraps = ring->userdata;
+    (*wraps)++;
+}
+
+static void draw_frame(RNE_DrawCmdBuffer* buffer, u32 frame) {
+    for (u32 i = 0; i < 256; i++) {
+        SP_Vec2 pos = sp_v2((i % 16) * 40.0f + frame, (i / 16) * 40.0f);
+        if (i % 7 == 0) {
+            rne_draw_scissor(buffer, (RNE_DrawScissor) {
+                    .pos = pos,
+                    .size = sp_v2s(400.0f),
+                });
+        }
+        rne_draw_rect_filled(buffer, (RNE_DrawRect) {
+                .pos = pos,
+                .size = sp_v2s(36.0f),
+                .corner_radius = sp_v4s(8.0f),
+                .corner_segments = 8,
+                .color = SP_COLOR_WHITE,
+            });
+        rne_draw_circle_stroke(buffer, (RNE_DrawCircle) {
+                .pos = sp_v2_add(pos, sp_v2s(18.0f)),
+                .radius = 4.0f + frame % 8,
+                .segments = 16 + frame % 16,
+                .color = SP_COLOR_WHITE,
+            }, 1.0f);
+    }
+}
+
+static RNE_Vertex vertex_buffer[4096];
+static u16 index_buffer[8192];
+
+i32 main(void) {
+    sp_init(SP_CONFIG_DEFAULT);
+    SP_Arena* arena = sp_arena_create();
+    SP_Arena* frame_arena = sp_arena_create();
+
+    RNE_FontInterface font = {
+        .get_sized = null_get_sized,
+        .get_glyph = null_get_glyph,
+        .get_atlas = null_get_atlas,
+        .get_metrics = null_get_metrics,
+    };
+
+    u32 wraps = 0;
+    RNE_RingBuffer vertex_ring = {
+        .capacity = sizeof(RNE_Vertex) * 16384,
+        .wrap = fake_ring_wrap,
+        .userdata = &wraps,
+    };
+    vertex_ring.data = sp_arena_push(arena, vertex_ring.capacity);
+    RNE_RingBuffer index_ring = {
+        .capacity = sizeof(u16) * 32768,
+        .wrap = fake_ring_wrap,
+        .userdata = &wraps,
+    };
+    index_ring.data = sp_arena_push(arena, index_ring.capacity);
+
+    u32 batches = 0;
+    u32 mismatches = 0;
+    for (u32 frame = 0; frame < 32; frame++) {
+        RNE_DrawCmdBuffer ring_draw = rne_draw_buffer_begin(frame_arena);
+        RNE_DrawCmdBuffer copy_draw = rne_draw_buffer_begin(frame_arena);
+        draw_frame(&ring_draw, frame);
+        draw_frame(&copy_draw, frame);
+
+        RNE_TessellationConfig config = {
+            .arena = frame_arena,
+            .font = font,
+            .vertex_buffer = vertex_buffer,
+            .vertex_capacity = sp_arrlen(vertex_buffer),
+            .index_buffer = index_buffer,
+            .index_capacity = sp_arrlen(index_buffer),
+        };
+        RNE_TessellationConfig ring_config = config;
+        ring_config.vertex_ring = &vertex_ring;
+        ring_config.index_ring = &index_ring;
+
+        RNE_TessellationState* ring_state = NULL;
+        RNE_TessellationState* copy_state = NULL;
+        while (true) {
+            RNE_Handle ring_textures[1];
+            RNE_Handle copy_textures[1];
+            ring_config.texture_buffer = ring_textures;
+            ring_config.texture_capacity = sp_arrlen(ring_textures);
+            config.texture_buffer = copy_textures;
+            config.texture_capacity = sp_arrlen(copy_textures);
+
+            RNE_BatchCmd ring_batch = rne_tessellate(&ring_draw, ring_config, &ring_state);
+            RNE_BatchCmd copy_batch = rne_tessellate(&copy_draw, config, &copy_state);
+            if (ring_batch.render_cmds == NULL || copy_batch.render_cmds == NULL) {
+                mismatches += ring_batch.render_cmds != copy_batch.render_cmds;
+                break;
+            }
+            batches++;
+
+            const RNE_Vertex* ring_vertices = (const RNE_Vertex*) vertex_ring.data + ring_batch.base_vertex;
+            if (ring_batch.vertex_count != copy_batch.vertex_count ||
+                    memcmp(ring_vertices, vertex_buffer, sizeof(RNE_Vertex) * copy_batch.vertex_count) != 0) {
+                mismatches++;
+            }
+
+            RNE_RenderCmd* copy_cmd = copy_batch.render_cmds;
+            for (RNE_RenderCmd* ring_cmd = ring_batch.render_cmds;
+                    ring_cmd != NULL && copy_cmd != NULL;
+                    ring_cmd = ring_cmd->next, copy_cmd = copy_cmd->next) {
+                const u8* ring_indices = (const u8*) index_ring.data + ring_cmd->start_offset_bytes;
+                const u8* copy_indices = (const u8*) index_buffer + copy_cmd->start_offset_bytes;
+                if (ring_cmd->index_count != copy_cmd->index_count ||
+                        memcmp(ring_indices, copy_indices, sizeof(u16) * copy_cmd->index_count) != 0) {
+                    mismatches++;
+                }
+            }
+        }
+
+        sp_arena_clear(frame_arena);
+    }
+
+    sp_info("%u batches, %u ring wraps, %u mismatches", batches, wraps, mismatches);
+    return mismatches != 0;
+}
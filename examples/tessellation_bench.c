@@ -0,0 +1,97 @@
+// Tessellation microbenchmark. Built twice, once with the SIMD kernels and
+// once with RUNE_NO_SIMD, to compare vertex throughput.
+
+#include "rune/rune.h"
+#include "rune/rune_tessellation.h"
+#include "spire.h"
+
+static RNE_Handle null_get_sized(RNE_Handle font, f32 size) {
+    (void) size;
+    return font;
+}
+
+static RNE_Glyph null_get_glyph(RNE_Handle sized_font, u32 codepoint) {
+    (void) sized_font;
+    (void) codepoint;
+    return (RNE_Glyph) {0};
+}
+
+static RNE_Handle null_get_atlas(RNE_Handle sized_font) {
+    return sized_font;
+}
+
+static RNE_FontMetrics null_get_metrics(RNE_Handle sized_font) {
+    (void) sized_font;
+    return (RNE_FontMetrics) {0};
+}
+
+static RNE_Vertex vertex_buffer[1 << 16];
+static u16 index_buffer[1 << 16];
+
+i32 main(void) {
+    sp_init(SP_CONFIG_DEFAULT);
+    SP_Arena* arena = sp_arena_create();
+    SP_Arena* frame_arena = sp_arena_create();
+
+    RNE_DrawCmdBuffer buffer = rne_draw_buffer_begin(arena);
+    for (u32 i = 0; i < 1024; i++) {
+        SP_Vec2 pos = sp_v2((i % 32) * 40.0f, (i / 32) * 40.0f);
+        RNE_DrawRect rect = {
+            .pos = pos,
+            .size = sp_v2s(36.0f),
+            .corner_radius = sp_v4s(8.0f),
+            .corner_segments = 8,
+            .color = SP_COLOR_WHITE,
+        };
+        rne_draw_rect_filled(&buffer, rect);
+        rne_draw_rect_stroke(&buffer, rect, 2.0f);
+        rne_draw_circle_stroke(&buffer, (RNE_DrawCircle) {
+                .pos = sp_v2_add(pos, sp_v2s(18.0f)),
+                .radius = 12.0f,
+                .segments = 32,
+                .color = SP_COLOR_WHITE,
+            }, 1.0f);
+    }
+
+    RNE_FontInterface font = {
+        .get_sized = null_get_sized,
+        .get_glyph = null_get_glyph,
+        .get_atlas = null_get_atlas,
+        .get_metrics = null_get_metrics,
+    };
+
+    const u32 iterations = 200;
+    u64 vertices = 0;
+    f32 start = sp_os_get_time();
+    for (u32 i = 0; i < iterations; i++) {
+        RNE_TessellationState* state = NULL;
+        RNE_Handle textures[1] = {0};
+        RNE_BatchCmd batch;
+        while ((batch = rne_tessellate(&buffer, (RNE_TessellationConfig) {
+                .arena = frame_arena,
+                .font = font,
+                .vertex_buffer = vertex_buffer,
+                .vertex_capacity = sp_arrlen(vertex_buffer),
+                .index_buffer = index_buffer,
+                .index_capacity = sp_arrlen(index_buffer),
+                .texture_buffer = textures,
+                .texture_capacity = sp_arrlen(textures),
+            }, &state)).render_cmds != NULL) {
+            vertices += batch.vertex_count;
+        }
+        sp_arena_clear(frame_arena);
+    }
+    f32 elapsed = sp_os_get_time() - start;
+
+#if defined(RUNE_NO_SIMD)
+    const char* kernels = "scalar";
+#else
+    const char* kernels = "simd";
+#endif
+    sp_info("%s: %.2f ms per frame, %.2f million vertices per second",
+            kernels,
+            elapsed * 1000.0f / iterations,
+            vertices / elapsed / 1000000.0f);
+
+    return 0;
+}
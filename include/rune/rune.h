@@ -30,7 +30,7 @@ union RNE_Handle {
 // DRAWING
 //
 // This provides a render agnostic API for rendering primitive shapes including
-// lines, arcs, circles, rectangles, images, text and specifying a scissor
+// lines, arcs, circles, rectangles, polygons, images, text and specifying a scissor
 // rectangle.
 //
 // Rune provides a tessellation module (rune_tessellation.h) which converts
@@ -46,6 +46,7 @@ typedef enum RNE_DrawCmdType {
     RNE_DRAW_CMD_TYPE_IMAGE,
     RNE_DRAW_CMD_TYPE_TEXT,
     RNE_DRAW_CMD_TYPE_SCISSOR,
+    RNE_DRAW_CMD_TYPE_POLYGON,
 } RNE_DrawCmdType;
 
 typedef struct RNE_DrawLine RNE_DrawLine;
@@ -83,8 +84,24 @@ struct RNE_DrawRect {
     SP_Color color;
 };
 
+// Simple polygon, convex or concave, without self-intersections. The points are
+// copied into the draw buffer so the array doesn't need to outlive the call.
+//
+// A polygon has to fit in a single batch, larger ones are skipped when
+// tessellating. A fill needs 'point_count' vertices and (point_count - 2) * 3
+// indices, a stroke 2 vertices and 6 indices per point. Anti-aliasing doubles
+// the vertices of a fill and adds 6 indices per point, strokes need 4
+// vertices and 18 indices per point.
+typedef struct RNE_DrawPolygon RNE_DrawPolygon;
+struct RNE_DrawPolygon {
+    const SP_Vec2* points;
+    u32 point_count;
+    SP_Color color;
+};
+
 typedef struct RNE_DrawText RNE_DrawText;
 struct RNE_DrawText {
+    // UTF-8 encoded.
     SP_Str text;
     SP_Vec2 pos;
     SP_Color color;
@@ -109,6 +126,19 @@ struct RNE_DrawScissor {
     SP_Vec2 size;
 };
 
+// Scissor in effect before any scissor command has been issued. Large enough
+// to never clip anything.
+#define RNE_SCISSOR_NONE ((RNE_DrawScissor) { \
+        .pos = sp_v2s(-(1<<13)), \
+        .size = sp_v2s(1<<14), \
+    })
+
+typedef struct RNE_ScissorNode RNE_ScissorNode;
+struct RNE_ScissorNode {
+    RNE_ScissorNode* next;
+    RNE_DrawScissor value;
+};
+
 // Drawing information stored inside a RNE_DrawCmdBuffer
 typedef struct RNE_DrawCmd RNE_DrawCmd;
 struct RNE_DrawCmd {
@@ -126,6 +156,7 @@ struct RNE_DrawCmd {
         RNE_DrawText text;
         RNE_DrawImage image;
         RNE_DrawScissor scissor;
+        RNE_DrawPolygon polygon;
     } data;
 
     // **DO NOT MODIFY THESE**
@@ -145,6 +176,8 @@ struct RNE_DrawCmdBuffer {
     SP_Arena* arena;
     RNE_DrawCmd* first;
     RNE_DrawCmd* last;
+    // Effective scissors pushed with rne_draw_scissor_push().
+    RNE_ScissorNode* scissor_stack;
 };
 
 // Initialize a draw buffer. There's no need to destroy or deinitialize it since
@@ -174,10 +207,12 @@ extern RNE_DrawCmdBuffer rne_draw_buffer_begin(SP_Arena* arena);
 extern void rne_draw_arc_filled(RNE_DrawCmdBuffer* buffer, RNE_DrawArc arc);
 extern void rne_draw_circle_filled(RNE_DrawCmdBuffer* buffer, RNE_DrawCircle circle);
 extern void rne_draw_rect_filled(RNE_DrawCmdBuffer* buffer, RNE_DrawRect rect);
+extern void rne_draw_polygon_filled(RNE_DrawCmdBuffer* buffer, RNE_DrawPolygon polygon);
 
 extern void rne_draw_arc_stroke(RNE_DrawCmdBuffer* buffer, RNE_DrawArc arc, f32 thickness);
 extern void rne_draw_circle_stroke(RNE_DrawCmdBuffer* buffer, RNE_DrawCircle circle, f32 thickness);
 extern void rne_draw_rect_stroke(RNE_DrawCmdBuffer* buffer, RNE_DrawRect rect, f32 thickness);
+extern void rne_draw_polygon_stroke(RNE_DrawCmdBuffer* buffer, RNE_DrawPolygon polygon, f32 thickness);
 
 extern void rne_draw_line(RNE_DrawCmdBuffer* buffer, RNE_DrawLine line);
 extern void rne_draw_image(RNE_DrawCmdBuffer* buffer, RNE_DrawImage image);
@@ -188,6 +223,31 @@ extern void rne_draw_text(RNE_DrawCmdBuffer* buffer, RNE_DrawText text);
 // recommended for performance.
 extern void rne_draw_scissor(RNE_DrawCmdBuffer* buffer, RNE_DrawScissor scissor);
 
+// Pushes a scissor onto the buffers scissor stack. The scissor is intersected
+// with the one currently on top of the stack so nested clip regions never draw
+// outside of their parents.
+extern void rne_draw_scissor_push(RNE_DrawCmdBuffer* buffer, RNE_DrawScissor scissor);
+// Pops the top scissor and restores the one below it. Nothing is pushed into
+// the command buffer if the restored scissor is the same as the popped one.
+extern void rne_draw_scissor_pop(RNE_DrawCmdBuffer* buffer);
+
+// =============================================================================
+// UTF-8
+// =============================================================================
+
+// Codepoint produced for malformed UTF-8 (U+FFFD REPLACEMENT CHARACTER).
+#define RNE_CODEPOINT_INVALID 0xfffd
+
+// Decodes the codepoint starting at byte '*offset' of 'text' and moves
+// '*offset' past it. Malformed, overlong or truncated sequences decode to
+// RNE_CODEPOINT_INVALID and only skip a single byte.
+//
+// USAGE:
+//      for (u32 offset = 0; offset < text.len;) {
+//          u32 codepoint = rne_utf8_decode(text, &offset);
+//      }
+extern u32 rne_utf8_decode(SP_Str text, u32* offset);
+
 // =============================================================================
 // WIDGET
 //
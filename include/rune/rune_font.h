@@ -5,31 +5,135 @@
 
 typedef RNE_Handle RNE_UserData;
 
+// Atlases grow by adding pages, each created with its own 'create' call.
+// Pages never change size and glyphs never move once uploaded with 'update'.
+// Textures from 'create' must start out zeroed. A page emptied by eviction is
+// zeroed again with an 'update' covering all of it.
 typedef RNE_UserData (*RNE_FontAtlasCreateFunc)(SP_Ivec2 size);
 typedef void (*RNE_FontAtlasDestroyFunc)(RNE_UserData userdata);
-typedef void (*RNE_FontAtlasResizeFunc)(RNE_UserData userdata, SP_Ivec2 size, const u8* pixels);
 typedef void (*RNE_FontAtlasUpdateFunc)(RNE_UserData userdata, SP_Ivec2 pos, SP_Ivec2 size, u32 stride, const u8* pixels);
 
 typedef struct RNE_FontCallbacks RNE_FontCallbacks;
 struct RNE_FontCallbacks {
     RNE_FontAtlasCreateFunc create;
     RNE_FontAtlasDestroyFunc destroy;
-    RNE_FontAtlasResizeFunc resize;
     RNE_FontAtlasUpdateFunc update;
 };
 
-extern RNE_Handle rne_font_create(SP_Arena* arena, SP_Str ttf_data, RNE_FontCallbacks callbacks);
+typedef enum RNE_AtlasPackerKind {
+    // Recursively splits free space into quadrants. Glyph sizes are rounded
+    // up to multiples of 4.
+    RNE_ATLAS_PACKER_QUADTREE,
+    // Bottom-left skyline packing with a pixel of padding between glyphs.
+    // Usually much denser for text since glyphs are of similar height.
+    RNE_ATLAS_PACKER_SKYLINE,
+} RNE_AtlasPackerKind;
+
+typedef struct RNE_FontConfig RNE_FontConfig;
+struct RNE_FontConfig {
+    RNE_FontCallbacks callbacks;
+    RNE_AtlasPackerKind atlas_packer;
+    // Budget and mirror of the atlas of each size, see RNE_FontAtlasConfig.
+    u64 atlas_budget_bytes;
+    b8 atlas_cpu_mirror;
+    // Optional atlas from 'rne_font_atlas_create'. When set, every size of the
+    // font packs its glyphs into it and the fields above are unused.
+    // Otherwise each size gets atlas pages of its own.
+    RNE_Handle shared_atlas;
+};
+
+typedef struct RNE_FontAtlasConfig RNE_FontAtlasConfig;
+struct RNE_FontAtlasConfig {
+    RNE_FontCallbacks callbacks;
+    RNE_AtlasPackerKind atlas_packer;
+    // Total page area in pixels, a byte each, that the atlas tries to stay
+    // within. Once reached, the least recently used page is emptied and reused
+    // instead of adding a new one, and its glyphs are rasterized again the next
+    // time they're requested. Pages used during the current frame are never
+    // evicted, so the budget is exceeded when a single frame needs more.
+    // Zero means no budget.
+    u64 budget_bytes;
+    // Keep a CPU copy of every page so textures can be uploaded again with
+    // 'rne_font_atlas_reupload', e.g. after losing the graphics device. Costs
+    // as much memory as the pages themselves and is off by default.
+    b8 cpu_mirror;
+};
+
+// Packing statistics summed over all pages of an atlas. Areas are in pixels.
+typedef struct RNE_AtlasStats RNE_AtlasStats;
+struct RNE_AtlasStats {
+    u32 page_count;
+    u32 glyph_count;
+    // Sum of the page areas.
+    u64 area;
+    // Sum of the glyph bitmap areas.
+    u64 glyph_area;
+    // Area the packer can no longer hand out, glyphs and waste alike.
+    u64 used_area;
+    // glyph_area / area.
+    f32 occupancy;
+    // Share of 'used_area' that is wasted: 1 - glyph_area / used_area.
+    f32 fragmentation;
+    // Pages emptied to stay within the budget.
+    u32 eviction_count;
+    // Memory held by CPU mirrors of the pages.
+    u64 mirror_bytes;
+};
+
+// An atlas shared between any number of fonts and sizes, so text of different
+// sizes and fonts ends up on the same textures and can be drawn in one batch.
+// It must outlive every font using it and is destroyed separately from them.
+extern RNE_Handle rne_font_atlas_create(SP_Arena* arena, RNE_FontAtlasConfig config);
+extern void rne_font_atlas_destroy(RNE_Handle* atlas);
+// Newest page, created if the atlas is still empty.
+extern RNE_Handle rne_font_atlas_get_page(RNE_Handle atlas);
+extern RNE_AtlasStats rne_font_atlas_stats(RNE_Handle atlas);
+// Uploads every page again through 'update', whole pages at a time. Only pages
+// with a CPU mirror are uploaded.
+extern void rne_font_atlas_reupload(RNE_Handle atlas);
+// Frames are what glyph usage is tracked in for eviction. Without calls to
+// this, nothing is ever evicted.
+extern void rne_font_atlas_end_frame(RNE_Handle atlas);
+
+extern RNE_Handle rne_font_create(SP_Arena* arena, SP_Str ttf_data, RNE_FontConfig config);
+// Destroys the atlas pages owned by the font's sizes. A shared atlas is left
+// alone.
 extern void rne_font_destroy(RNE_Handle* font);
+// Same as 'rne_font_atlas_reupload' for the atlases owned by the font's sizes.
+extern void rne_font_reupload(RNE_Handle font);
+// Same as 'rne_font_atlas_end_frame' for the atlases owned by the font's sizes.
+// A shared atlas has to be advanced on its own.
+extern void rne_font_end_frame(RNE_Handle font);
+
+// Resolves a font at a specific size. The handle stays valid until the font is
+// destroyed, and the rne_sized_* functions taking it skip the size lookup the
+// functions below do on every call.
+extern RNE_Handle rne_font_sized(RNE_Handle font, f32 size);
+
+extern SP_Vec2 rne_sized_text_measure(RNE_Handle sized_font, SP_Str text);
+extern RNE_Glyph rne_sized_font_get_glyph(RNE_Handle sized_font, u32 codepoint);
+// See RNE_FontLayoutRunFunc.
+extern u32 rne_sized_font_layout_run(RNE_Handle sized_font, SP_Str text, SP_Vec2* out_positions, RNE_Glyph* out_glyphs);
+// Newest atlas page. Glyphs can live on any page, see RNE_Glyph.atlas.
+extern RNE_Handle rne_sized_font_get_atlas(RNE_Handle sized_font);
+extern RNE_FontMetrics rne_sized_font_get_metrics(RNE_Handle sized_font);
+extern f32 rne_sized_font_get_kerning(RNE_Handle sized_font, u32 left_codepoint, u32 right_codepoint);
+// Stats of the atlas the size packs into, which covers every user of a shared
+// atlas. All zero until a glyph has been rasterized into it.
+extern RNE_AtlasStats rne_sized_font_atlas_stats(RNE_Handle sized_font);
 
 extern SP_Vec2 rne_text_measure(RNE_Handle font, SP_Str text, f32 size);
 extern RNE_Glyph rne_font_get_glyph(RNE_Handle font, u32 codepoint, f32 size);
+extern u32 rne_font_layout_run(RNE_Handle font, f32 size, SP_Str text, SP_Vec2* out_positions, RNE_Glyph* out_glyphs);
 extern RNE_Handle rne_font_get_atlas(RNE_Handle font, f32 size);
 extern RNE_FontMetrics rne_font_get_metrics(RNE_Handle font, f32 size);
 extern f32 rne_font_get_kerning(RNE_Handle font, u32 left_codepoint, u32 right_codepoint, f32 size);
 
 #define RNE_FONT_INTERFACE ((RNE_FontInterface) { \
-    .get_glyph = rne_font_get_glyph, \
-    .get_atlas = rne_font_get_atlas, \
-    .get_metrics = rne_font_get_metrics, \
-    .get_kerning = rne_font_get_kerning, \
+    .get_sized = rne_font_sized, \
+    .get_glyph = rne_sized_font_get_glyph, \
+    .get_atlas = rne_sized_font_get_atlas, \
+    .get_metrics = rne_sized_font_get_metrics, \
+    .get_kerning = rne_sized_font_get_kerning, \
+    .layout_run = rne_sized_font_layout_run, \
 })
@@ -10,6 +10,9 @@ struct RNE_Glyph {
     // [0] = Top left
     // [1] = Bottom right
     SP_Vec2 uv[2];
+    // Texture the glyph lives in. Fonts with a single atlas per size can leave
+    // it empty, the one from 'get_atlas' is used then.
+    RNE_Handle atlas;
 };
 
 typedef struct RNE_FontMetrics RNE_FontMetrics;
@@ -19,28 +22,142 @@ struct RNE_FontMetrics {
     f32 linegap;
 };
 
-typedef RNE_Glyph (*RNE_FontGetGlyphFunc)(RNE_Handle font, u32 codepoint, f32 size);
-typedef RNE_Handle (*RNE_FontGetAtlasFunc)(RNE_Handle font, f32 size);
-typedef RNE_FontMetrics (*RNE_FontGetMetricsFunc)(RNE_Handle font, f32 size);
-typedef f32 (*RNE_FontGetKerningFunc)(RNE_Handle font, u32 left_codepoint, u32 right_codepoint, f32 size);
+// Resolves a font and size into a sized font handle. Called once per text
+// command, every other function is given the handle it returns.
+typedef RNE_Handle (*RNE_FontGetSizedFunc)(RNE_Handle font, f32 size);
+typedef RNE_Glyph (*RNE_FontGetGlyphFunc)(RNE_Handle sized_font, u32 codepoint);
+typedef RNE_Handle (*RNE_FontGetAtlasFunc)(RNE_Handle sized_font);
+typedef RNE_FontMetrics (*RNE_FontGetMetricsFunc)(RNE_Handle sized_font);
+typedef f32 (*RNE_FontGetKerningFunc)(RNE_Handle sized_font, u32 left_codepoint, u32 right_codepoint);
+// Lays out a whole UTF-8 string in one call. Writes one glyph and one pen
+// position per codepoint and returns the number written. Positions are
+// relative to the pen at the start of the string and include kerning, the
+// glyph offset is not applied. Both arrays must hold 'text.len' entries.
+typedef u32 (*RNE_FontLayoutRunFunc)(RNE_Handle sized_font, SP_Str text, SP_Vec2* out_positions, RNE_Glyph* out_glyphs);
 
 typedef struct RNE_FontInterface RNE_FontInterface;
 struct RNE_FontInterface {
+    RNE_FontGetSizedFunc get_sized;
     RNE_FontGetGlyphFunc get_glyph;
     RNE_FontGetAtlasFunc get_atlas;
     RNE_FontGetMetricsFunc get_metrics;
     // Can be left as null.
     RNE_FontGetKerningFunc get_kerning;
+    // Can be left as null, text is then laid out with 'get_glyph' and
+    // 'get_kerning' one codepoint at a time.
+    RNE_FontLayoutRunFunc layout_run;
 };
 
 typedef struct RNE_Vertex RNE_Vertex;
+#ifdef RUNE_COMPACT_VERTEX
+// 20 byte layout, enabled with the RUNE_COMPACT_VERTEX CMake option. UVs are
+// clamped to [-1, 1] and the texture index and layer must fit in a byte.
+//
+//  offset  0: pos              2 x f32
+//  offset  8: uv               2 x snorm16
+//  offset 12: color            4 x unorm8
+//  offset 16: texture_index    u8
+//  offset 17: texture_layer    u8
+//  offset 18: padding, always zero
+struct RNE_Vertex {
+    SP_Vec2 pos;
+    // Signed normalized, arcs and circles carry unit circle coordinates.
+    i16 uv[2];
+    // Unsigned normalized RGBA.
+    u8 color[4];
+    u8 texture_index;
+    // Only written when 'get_texture_slot' is set in the config.
+    u8 texture_layer;
+};
+#else
+// 40 byte layout. Arcs and circles carry unit circle coordinates as UVs.
 struct RNE_Vertex {
     SP_Vec2 pos;
     SP_Vec2 uv;
     SP_Color color;
     u32 texture_index;
+    // Only written when 'get_texture_slot' is set in the config.
+    u32 texture_layer;
+};
+#endif
+
+// Compact description of a rounded rectangle, circle, image or glyph, meant to
+// be drawn as one instanced quad by the backend. The exact coverage the record
+// describes is defined by rne_instance_coverage() and rne_instance_uv().
+typedef struct RNE_Instance RNE_Instance;
+struct RNE_Instance {
+    SP_Vec2 pos;
+    SP_Vec2 size;
+    // Already clamped to half of the smallest side.
+    //  x: top left     y: top right,
+    //  z: bottom left  w: bottom right
+    SP_Vec4 corner_radius;
+    SP_Color color;
+    // [0] = Top left
+    // [1] = Bottom right
+    SP_Vec2 uv[2];
+    u32 texture_index;
+    // Only written when 'get_texture_slot' is set in the config.
+    u32 texture_layer;
+    // Outline thickness growing inwards. Zero means filled.
+    f32 stroke_width;
+};
+
+typedef enum RNE_IndexType {
+    // Limits a batch to 65536 vertices.
+    RNE_INDEX_TYPE_U16,
+    RNE_INDEX_TYPE_U32,
+} RNE_IndexType;
+
+// Persistently mapped GPU buffer that batches are written into directly.
+// Each batch reserves 'vertex_capacity' vertices or 'index_capacity' indices
+// from the write offset. If they don't fit before the end of the ring, 'wrap'
+// is called and writing restarts at offset 0. The host must make sure the GPU
+// is done with the old contents before returning from 'wrap', e.g. by waiting
+// on a fence. After each batch 'offset' is moved past what was written.
+typedef struct RNE_RingBuffer RNE_RingBuffer;
+typedef void (*RNE_RingWrapFunc)(RNE_RingBuffer* ring);
+struct RNE_RingBuffer {
+    void* data;
+    // In bytes.
+    u32 capacity;
+    u32 offset;
+    RNE_RingWrapFunc wrap;
+    void* userdata;
+};
+
+// Where a texture lives for hosts using texture arrays or bindless handles.
+typedef struct RNE_TextureSlot RNE_TextureSlot;
+struct RNE_TextureSlot {
+    u32 index;
+    u32 layer;
+};
+
+typedef RNE_TextureSlot (*RNE_GetTextureSlotFunc)(RNE_Handle texture);
+
+// Keeps the tessellated geometry of shapes across frames, keyed by the content
+// of their draw commands. Least recently used entries are evicted to stay
+// within the byte budget. Glyphs and images aren't cached, a quad is cheaper
+// to build than to look up.
+typedef struct RNE_TessellationCache RNE_TessellationCache;
+
+typedef struct RNE_TessellationCacheStats RNE_TessellationCacheStats;
+struct RNE_TessellationCacheStats {
+    // Counted once per emitted command, a command retried in the next batch
+    // because the current one was full isn't counted again.
+    u64 hits;
+    u64 misses;
+    u64 evictions;
+    u32 entry_count;
+    u32 bytes_used;
 };
 
+// Everything is allocated on the provided arena, which has to outlive the
+// cache. Cached geometry lives in a single region of at most 'byte_budget'
+// bytes, allocated on first use. Memory of evicted entries is reused.
+extern RNE_TessellationCache* rne_tessellation_cache_create(SP_Arena* arena, u32 byte_budget);
+extern RNE_TessellationCacheStats rne_tessellation_cache_stats(const RNE_TessellationCache* cache);
+
 typedef struct RNE_TessellationConfig RNE_TessellationConfig;
 struct RNE_TessellationConfig {
     SP_Arena* arena;
@@ -49,33 +166,161 @@ struct RNE_TessellationConfig {
     RNE_Vertex* vertex_buffer;
     u32 vertex_capacity;
 
-    u16* index_buffer;
+    // Array of u16 or u32 depending on 'index_type'.
+    void* index_buffer;
+    RNE_IndexType index_type;
     u32 index_capacity;
 
+    // Optional. When set, vertices and indices are written straight into
+    // these rings instead of 'vertex_buffer' and 'index_buffer'. The
+    // capacities above still limit the size of a single batch.
+    RNE_RingBuffer* vertex_ring;
+    RNE_RingBuffer* index_ring;
+
+    // Optional. When set, rects, circles, images and glyphs are emitted as
+    // instances instead of triangles. Everything else still uses the vertex
+    // and index buffers.
+    RNE_Instance* instance_buffer;
+    u32 instance_capacity;
+
     RNE_Handle* texture_buffer;
     u32 texture_capacity;
     RNE_Handle null_texture;
+
+    // Optional. When set, vertices and instances get the index and layer of
+    // their texture from this function instead of an index into
+    // 'texture_buffer', which is then unused. Batches never break because of
+    // the number of textures.
+    RNE_GetTextureSlotFunc get_texture_slot;
+
+    // Maximum distance in pixels between a tessellated arc and the true
+    // curve. When non-zero, segment counts of arcs, circles and rounded
+    // corners are derived from their radius and the segment counts stored in
+    // the draw commands are ignored. 0.25 is a good starting point.
+    f32 arc_max_error;
+
+    // Applied to every command as 'pos * scale + offset', so one draw buffer
+    // can be tessellated for several targets. Sizes, radii and thicknesses
+    // are scaled too and text is laid out at the scaled font size. A scale
+    // of 0 is treated as 1.
+    f32 scale;
+    SP_Vec2 offset;
+
+    // Optional. Reuses geometry from earlier frames for identical shapes.
+    // Ignored by parallel jobs.
+    RNE_TessellationCache* cache;
+
+    // Surround fills and strokes with a one pixel wide alpha feathered fringe
+    // so the host doesn't need MSAA. Fills use twice the vertices and strokes
+    // four instead of two vertices per point. Images and text are left as
+    // they are.
+    b8 anti_aliasing;
 };
 
+typedef enum RNE_RenderCmdType {
+    // Indexed triangles from the vertex and index buffers.
+    RNE_RENDER_CMD_TYPE_TRIANGLES,
+    // Instanced quads from the instance buffer.
+    RNE_RENDER_CMD_TYPE_INSTANCES,
+} RNE_RenderCmdType;
+
 typedef struct RNE_RenderCmd RNE_RenderCmd;
 struct RNE_RenderCmd {
     RNE_RenderCmd* next;
+    RNE_RenderCmdType type;
 
+    // RNE_RENDER_CMD_TYPE_TRIANGLES
+    // From the start of the index buffer, or of the index ring.
     u32 start_offset_bytes;
     u32 index_count;
+
+    // RNE_RENDER_CMD_TYPE_INSTANCES
+    u32 first_instance;
+    u32 instance_count;
+
     RNE_DrawScissor scissor;
 };
 
 typedef struct RNE_BatchCmd RNE_BatchCmd;
 struct RNE_BatchCmd {
+    // Index of the first vertex in the vertex ring, to be used as base
+    // vertex when drawing. Always 0 without a ring.
+    u32 base_vertex;
     u32 vertex_count;
     u32 index_count;
+    u32 instance_count;
     u32 texture_count;
     RNE_RenderCmd* render_cmds;
 };
 
 typedef struct RNE_TessellationState RNE_TessellationState;
 
-extern RNE_BatchCmd rne_tessellate(RNE_DrawCmdBuffer* buffer,
+// The draw buffer isn't modified, so it can be tessellated any number of
+// times, e.g. once per render target with a different scale.
+extern RNE_BatchCmd rne_tessellate(const RNE_DrawCmdBuffer* buffer,
         RNE_TessellationConfig config,
         RNE_TessellationState** state);
+
+// Parallel tessellation. Rune doesn't spawn threads itself, the host runs the
+// jobs on whatever threads it has:
+//
+//     RNE_TessellationJobs* jobs = rne_tessellate_split(&buffer, config, worker_count);
+//     for each job i, on any thread:
+//         rne_tessellate_job_run(jobs, i, worker_arena);
+//     RNE_BatchCmd batch;
+//     if (!rne_tessellate_merge(jobs, &batch)) {
+//         // Didn't fit in one batch, fall back to rne_tessellate().
+//     }
+//
+// The merged batch is byte-identical to the first batch rne_tessellate()
+// would produce. Jobs only read the draw buffer and write to their own arena,
+// which must stay alive until the merge. rne_tessellate_split() requests every
+// glyph up front, so jobs only query glyphs the font already has cached. The
+// built-in font doesn't modify anything on a cache hit for a glyph that was
+// already requested in the current frame, so the atlas frame must not be
+// advanced between the split and the merge.
+typedef struct RNE_TessellationJobs RNE_TessellationJobs;
+
+extern RNE_TessellationJobs* rne_tessellate_split(const RNE_DrawCmdBuffer* buffer,
+        RNE_TessellationConfig config,
+        u32 max_jobs);
+extern u32 rne_tessellate_job_count(const RNE_TessellationJobs* jobs);
+extern void rne_tessellate_job_run(RNE_TessellationJobs* jobs, u32 index, SP_Arena* arena);
+// Returns false if the combined output doesn't fit in the buffers of the
+// config given to rne_tessellate_split().
+extern b8 rne_tessellate_merge(RNE_TessellationJobs* jobs, RNE_BatchCmd* batch);
+
+// CPU reference for the instanced quad shader. The final color of a pixel is
+//      texture(textures[texture_index], rne_instance_uv(...)) * color * rne_instance_coverage(...)
+// where 'point' is the pixel center. The quad drawn for an instance must cover
+// its rect expanded by one pixel for the anti-aliased edge.
+extern f32 rne_instance_coverage(RNE_Instance instance, SP_Vec2 point);
+extern SP_Vec2 rne_instance_uv(RNE_Instance instance, SP_Vec2 point);
+
+typedef struct RNE_ReorderStats RNE_ReorderStats;
+struct RNE_ReorderStats {
+    // Number of drawing commands, scissor commands excluded.
+    u32 cmd_count;
+    // Number of scissor runs, each of which becomes at least one RNE_RenderCmd.
+    u32 render_cmds_before;
+    u32 render_cmds_after;
+    // Number of times consecutive commands, or consecutive glyphs of text
+    // spanning several atlas pages, use different textures.
+    u32 texture_switches_before;
+    u32 texture_switches_after;
+};
+
+// Optional pass to run between rne_draw() and rne_tessellate(). Groups
+// commands sharing the same scissor and texture so fewer render commands and
+// batches are produced. A command is only moved past commands it doesn't
+// overlap, so painter's order is preserved wherever it matters. Text spanning
+// several atlas pages is never grouped with other commands.
+//
+// 'null_texture' must be the one later given to rne_tessellate(), so
+// untextured shapes are grouped with images drawn with that texture.
+//
+// Reorders the commands of the buffer in place, call it before tessellating.
+// Scissor commands are regenerated, only where the scissor actually changes.
+extern RNE_ReorderStats rne_reorder(RNE_DrawCmdBuffer* buffer,
+        RNE_FontInterface font,
+        RNE_Handle null_texture);
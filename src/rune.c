@@ -587,13 +587,13 @@ static void rne_draw_helper(RNE_DrawCmdBuffer* buffer, RNE_Widget* widget) {
         return;
     }
 
-    b8 reset_scissor = false;
+    b8 pop_scissor = false;
     if (widget->flags & RNE_WIDGET_FLAG_CLIP) {
-        rne_draw_scissor(buffer, (RNE_DrawScissor) {
+        rne_draw_scissor_push(buffer, (RNE_DrawScissor) {
                 .pos = widget->computed_absolute_position,
                 .size = widget->computed_outer_size,
             });
-        reset_scissor = true;
+        pop_scissor = true;
     }
 
     if (widget->flags & RNE_WIDGET_FLAG_DRAW_BACKGROUND) {
@@ -642,11 +642,8 @@ static void rne_draw_helper(RNE_DrawCmdBuffer* buffer, RNE_Widget* widget) {
     // Depth-first
     rne_draw_helper(buffer, widget->child_first);
 
-    if (reset_scissor) {
-        rne_draw_scissor(buffer, (RNE_DrawScissor) {
-                .pos = sp_v2s(-(1<<13)),
-                .size = sp_v2s(1<<14),
-            });
+    if (pop_scissor) {
+        rne_draw_scissor_pop(buffer);
     }
     rne_draw_helper(buffer, widget->next);
 }
@@ -906,6 +903,31 @@ void rne_draw_rect_stroke(RNE_DrawCmdBuffer* buffer, RNE_DrawRect rect, f32 thic
         });
 }
 
+static RNE_DrawPolygon polygon_copy(RNE_DrawCmdBuffer* buffer, RNE_DrawPolygon polygon) {
+    SP_Vec2* points = sp_arena_push_no_zero(buffer->arena, sizeof(SP_Vec2) * polygon.point_count);
+    memcpy(points, polygon.points, sizeof(SP_Vec2) * polygon.point_count);
+    polygon.points = points;
+    return polygon;
+}
+
+void rne_draw_polygon_filled(RNE_DrawCmdBuffer* buffer, RNE_DrawPolygon polygon) {
+    rne_draw_buffer_push(buffer, (RNE_DrawCmd) {
+            .type = RNE_DRAW_CMD_TYPE_POLYGON,
+            .filled = true,
+            .data.polygon = polygon_copy(buffer, polygon),
+        });
+}
+
+void rne_draw_polygon_stroke(RNE_DrawCmdBuffer* buffer, RNE_DrawPolygon polygon, f32 thickness) {
+    rne_draw_buffer_push(buffer, (RNE_DrawCmd) {
+            .type = RNE_DRAW_CMD_TYPE_POLYGON,
+            .filled = false,
+            .closed = true,
+            .thickness = thickness,
+            .data.polygon = polygon_copy(buffer, polygon),
+        });
+}
+
 void rne_draw_image(RNE_DrawCmdBuffer* buffer, RNE_DrawImage image) {
     rne_draw_buffer_push(buffer, (RNE_DrawCmd) {
             .type = RNE_DRAW_CMD_TYPE_IMAGE,
@@ -927,3 +949,96 @@ void rne_draw_scissor(RNE_DrawCmdBuffer* buffer, RNE_DrawScissor scissor) {
             .data.scissor = scissor,
         });
 }
+
+static RNE_DrawScissor scissor_intersect(RNE_DrawScissor a, RNE_DrawScissor b) {
+    SP_Vec2 min = sp_v2(sp_max(a.pos.x, b.pos.x), sp_max(a.pos.y, b.pos.y));
+    SP_Vec2 max = sp_v2(sp_min(a.pos.x + a.size.x, b.pos.x + b.size.x),
+            sp_min(a.pos.y + a.size.y, b.pos.y + b.size.y));
+    return (RNE_DrawScissor) {
+        .pos = min,
+        .size = sp_v2(sp_max(max.x - min.x, 0.0f), sp_max(max.y - min.y, 0.0f)),
+    };
+}
+
+static RNE_DrawScissor scissor_top(const RNE_DrawCmdBuffer* buffer) {
+    if (buffer->scissor_stack == NULL) {
+        return RNE_SCISSOR_NONE;
+    }
+    return buffer->scissor_stack->value;
+}
+
+void rne_draw_scissor_push(RNE_DrawCmdBuffer* buffer, RNE_DrawScissor scissor) {
+    RNE_DrawScissor parent = scissor_top(buffer);
+    RNE_ScissorNode* node = sp_arena_push_no_zero(buffer->arena, sizeof(RNE_ScissorNode));
+    *node = (RNE_ScissorNode) {
+        .value = scissor_intersect(parent, scissor),
+        .next = NULL,
+    };
+    sp_sll_stack_push(buffer->scissor_stack, node);
+    rne_draw_scissor(buffer, node->value);
+}
+
+void rne_draw_scissor_pop(RNE_DrawCmdBuffer* buffer) {
+    sp_assert(buffer->scissor_stack != NULL, "Too many pops on the scissor stack!");
+    RNE_DrawScissor popped = buffer->scissor_stack->value;
+    sp_sll_stack_pop(buffer->scissor_stack);
+    RNE_DrawScissor restored = scissor_top(buffer);
+    if (memcmp(&popped, &restored, sizeof(RNE_DrawScissor)) != 0) {
+        rne_draw_scissor(buffer, restored);
+    }
+}
+
+// -- UTF-8 --------------------------------------------------------------------
+
+u32 rne_utf8_decode(SP_Str text, u32* offset) {
+    sp_assert(*offset < text.len, "Decoding past the end of the string.");
+    const u8* bytes = &text.data[*offset];
+    u32 remaining = text.len - *offset;
+
+    u8 lead = bytes[0];
+    u32 length;
+    u32 codepoint;
+    u32 min;
+    if (lead < 0x80) {
+        *offset += 1;
+        return lead;
+    } else if ((lead & 0xe0) == 0xc0) {
+        length = 2;
+        codepoint = lead & 0x1f;
+        min = 0x80;
+    } else if ((lead & 0xf0) == 0xe0) {
+        length = 3;
+        codepoint = lead & 0x0f;
+        min = 0x800;
+    } else if ((lead & 0xf8) == 0xf0) {
+        length = 4;
+        codepoint = lead & 0x07;
+        min = 0x10000;
+    } else {
+        *offset += 1;
+        return RNE_CODEPOINT_INVALID;
+    }
+
+    if (length > remaining) {
+        *offset += 1;
+        return RNE_CODEPOINT_INVALID;
+    }
+    for (u32 i = 1; i < length; i++) {
+        if ((bytes[i] & 0xc0) != 0x80) {
+            *offset += 1;
+            return RNE_CODEPOINT_INVALID;
+        }
+        codepoint = (codepoint << 6) | (bytes[i] & 0x3f);
+    }
+
+    // Overlong encodings, UTF-16 surrogates and values past the Unicode range.
+    if (codepoint < min ||
+            (codepoint >= 0xd800 && codepoint <= 0xdfff) ||
+            codepoint > 0x10ffff) {
+        *offset += 1;
+        return RNE_CODEPOINT_INVALID;
+    }
+
+    *offset += length;
+    return codepoint;
+}
@@ -21,8 +21,8 @@ typedef struct QuadtreeAtlas QuadtreeAtlas;
 struct QuadtreeAtlas {
     SP_Arena* arena;
     QuadtreeAtlasNode root;
-    SP_Ivec2 size;
-    u8* bitmap;
+    // Child arrays released by a reset, linked through their first child.
+    QuadtreeAtlasNode* free_children;
 };
 
 static QuadtreeAtlas quadtree_atlas_init(SP_Arena* arena, SP_Ivec2 size) {
@@ -31,8 +31,6 @@ static QuadtreeAtlas quadtree_atlas_init(SP_Arena* arena, SP_Ivec2 size) {
         .root = {
             .size = size,
         },
-        .size = size,
-        .bitmap = sp_arena_push(arena, size.x * size.y),
     };
     return atlas;
 }
@@ -44,7 +42,16 @@ static u32 align_value_up(u32 value, u32 align) {
     return aligned;
 }
 
-static QuadtreeAtlasNode* quadtree_atlas_insert_helper(SP_Arena* arena, QuadtreeAtlasNode* node, SP_Ivec2 size) {
+static QuadtreeAtlasNode* quadtree_atlas_push_children(QuadtreeAtlas* atlas) {
+    QuadtreeAtlasNode* children = atlas->free_children;
+    if (children == NULL) {
+        return sp_arena_push_no_zero(atlas->arena, 4 * sizeof(QuadtreeAtlasNode));
+    }
+    atlas->free_children = children[0].children;
+    return children;
+}
+
+static QuadtreeAtlasNode* quadtree_atlas_insert_helper(QuadtreeAtlas* atlas, QuadtreeAtlasNode* node, SP_Ivec2 size) {
     if (node == NULL || node->occupied || node->size.x < size.x || node->size.y < size.y) {
         return NULL;
     }
@@ -55,7 +62,7 @@ static QuadtreeAtlasNode* quadtree_atlas_insert_helper(SP_Arena* arena, Quadtree
             return node;
         }
 
-        node->children = sp_arena_push_no_zero(arena, 4 * sizeof(QuadtreeAtlasNode));
+        node->children = quadtree_atlas_push_children(atlas);
         node->split = true;
 
         // Dynamic split
@@ -90,6 +97,12 @@ static QuadtreeAtlasNode* quadtree_atlas_insert_helper(SP_Arena* arena, Quadtree
                 };
             }
 
+            // Remaining bottom right corner.
+            node->children[3] = (QuadtreeAtlasNode) {
+                .size = sp_iv2_sub(node->size, size),
+                .pos = sp_iv2_add(node->pos, size),
+            };
+
             return &node->children[0];
         }
 
@@ -113,7 +126,7 @@ static QuadtreeAtlasNode* quadtree_atlas_insert_helper(SP_Arena* arena, Quadtree
     }
 
     for (u8 i = 0; i < 4; i++) {
-        QuadtreeAtlasNode* result = quadtree_atlas_insert_helper(arena, &node->children[i], size);
+        QuadtreeAtlasNode* result = quadtree_atlas_insert_helper(atlas, &node->children[i], size);
         if (result != NULL) {
             return result;
         }
@@ -125,7 +138,269 @@ static QuadtreeAtlasNode* quadtree_atlas_insert_helper(SP_Arena* arena, Quadtree
 static QuadtreeAtlasNode* quadtree_atlas_insert(QuadtreeAtlas* atlas, SP_Ivec2 size) {
     size.x = align_value_up(size.x, 4);
     size.y = align_value_up(size.y, 4);
-    return quadtree_atlas_insert_helper(atlas->arena, &atlas->root, size);
+    return quadtree_atlas_insert_helper(atlas, &atlas->root, size);
+}
+
+static void quadtree_atlas_release_helper(QuadtreeAtlas* atlas, QuadtreeAtlasNode* node) {
+    if (!node->split) {
+        return;
+    }
+    QuadtreeAtlasNode* children = node->children;
+    for (u8 i = 0; i < 4; i++) {
+        quadtree_atlas_release_helper(atlas, &children[i]);
+    }
+    children[0].children = atlas->free_children;
+    atlas->free_children = children;
+}
+
+// Empties the atlas, keeping its nodes around for reuse.
+static void quadtree_atlas_reset(QuadtreeAtlas* atlas) {
+    quadtree_atlas_release_helper(atlas, &atlas->root);
+    atlas->root = (QuadtreeAtlasNode) {
+        .size = atlas->root.size,
+    };
+}
+
+// Area of the leaves still available for glyphs.
+static u64 quadtree_atlas_free_area(const QuadtreeAtlasNode* node) {
+    if (!node->split) {
+        return node->occupied ? 0 : (u64) node->size.x * node->size.y;
+    }
+    u64 area = 0;
+    for (u8 i = 0; i < 4; i++) {
+        area += quadtree_atlas_free_area(&node->children[i]);
+    }
+    return area;
+}
+
+// -- Skyline packer -----------------------------------------------------------
+
+// Bottom-left skyline packing. The skyline is the top edge of everything packed
+// so far, stored as horizontal segments from left to right. A glyph is placed
+// on the segment where its bottom edge ends up lowest.
+
+typedef struct SkylineNode SkylineNode;
+struct SkylineNode {
+    i32 x;
+    i32 y;
+    i32 width;
+};
+
+typedef struct SkylineAtlas SkylineAtlas;
+struct SkylineAtlas {
+    SkylineNode* nodes;
+    u32 node_count;
+    SP_Ivec2 size;
+};
+
+// Empty pixels kept between glyphs so linear filtering doesn't bleed.
+#define SKYLINE_PADDING 1
+
+static SkylineAtlas skyline_atlas_init(SP_Arena* arena, SP_Ivec2 size) {
+    // Every node is at least a pixel wide, plus one while inserting.
+    SkylineAtlas atlas = {
+        .nodes = sp_arena_push_no_zero(arena, sizeof(SkylineNode) * (size.x + 1)),
+        .node_count = 1,
+        .size = size,
+    };
+    atlas.nodes[0] = (SkylineNode) {
+        .x = 0,
+        .y = 0,
+        .width = size.x,
+    };
+    return atlas;
+}
+
+static void skyline_atlas_reset(SkylineAtlas* atlas) {
+    atlas->nodes[0] = (SkylineNode) {
+        .x = 0,
+        .y = 0,
+        .width = atlas->size.x,
+    };
+    atlas->node_count = 1;
+}
+
+// Y coordinate a rect would be placed at when its left edge is at node 'index',
+// or -1 if it doesn't fit there.
+static i32 skyline_atlas_fit(const SkylineAtlas* atlas, u32 index, SP_Ivec2 size) {
+    if (atlas->nodes[index].x + size.x > atlas->size.x) {
+        return -1;
+    }
+
+    i32 y = 0;
+    i32 width_left = size.x;
+    for (u32 i = index; width_left > 0; i++) {
+        y = sp_max(y, atlas->nodes[i].y);
+        if (y + size.y > atlas->size.y) {
+            return -1;
+        }
+        width_left -= atlas->nodes[i].width;
+    }
+    return y;
+}
+
+static void skyline_atlas_remove(SkylineAtlas* atlas, u32 index) {
+    memmove(&atlas->nodes[index], &atlas->nodes[index + 1], sizeof(SkylineNode) * (atlas->node_count - index - 1));
+    atlas->node_count--;
+}
+
+static b8 skyline_atlas_insert(SkylineAtlas* atlas, SP_Ivec2 size, SP_Ivec2* pos) {
+    size = sp_iv2_add(size, sp_iv2(SKYLINE_PADDING, SKYLINE_PADDING));
+
+    i32 best_index = -1;
+    i32 best_bottom = 0;
+    i32 best_width = 0;
+    for (u32 i = 0; i < atlas->node_count; i++) {
+        i32 y = skyline_atlas_fit(atlas, i, size);
+        if (y < 0) {
+            continue;
+        }
+        i32 bottom = y + size.y;
+        if (best_index < 0 ||
+                bottom < best_bottom ||
+                (bottom == best_bottom && atlas->nodes[i].width < best_width)) {
+            best_index = i;
+            best_bottom = bottom;
+            best_width = atlas->nodes[i].width;
+        }
+    }
+    if (best_index < 0) {
+        return false;
+    }
+
+    SkylineNode node = {
+        .x = atlas->nodes[best_index].x,
+        .y = best_bottom,
+        .width = size.x,
+    };
+    *pos = sp_iv2(node.x, best_bottom - size.y);
+
+    memmove(&atlas->nodes[best_index + 1], &atlas->nodes[best_index], sizeof(SkylineNode) * (atlas->node_count - best_index));
+    atlas->nodes[best_index] = node;
+    atlas->node_count++;
+
+    // Cut away the parts of the following segments now covered by the new one.
+    for (u32 i = best_index + 1; i < atlas->node_count;) {
+        SkylineNode* prev = &atlas->nodes[i - 1];
+        SkylineNode* curr = &atlas->nodes[i];
+        i32 overlap = prev->x + prev->width - curr->x;
+        if (overlap <= 0) {
+            break;
+        }
+        curr->x += overlap;
+        curr->width -= overlap;
+        if (curr->width > 0) {
+            break;
+        }
+        skyline_atlas_remove(atlas, i);
+    }
+
+    // Merge neighbouring segments at the same height.
+    for (u32 i = 0; i + 1 < atlas->node_count;) {
+        if (atlas->nodes[i].y == atlas->nodes[i + 1].y) {
+            atlas->nodes[i].width += atlas->nodes[i + 1].width;
+            skyline_atlas_remove(atlas, i + 1);
+        } else {
+            i++;
+        }
+    }
+
+    return true;
+}
+
+static u64 skyline_atlas_free_area(const SkylineAtlas* atlas) {
+    u64 area = 0;
+    for (u32 i = 0; i < atlas->node_count; i++) {
+        area += (u64) atlas->nodes[i].width * (atlas->size.y - atlas->nodes[i].y);
+    }
+    return area;
+}
+
+// -- Atlas packer -------------------------------------------------------------
+
+typedef struct AtlasPacker AtlasPacker;
+struct AtlasPacker {
+    RNE_AtlasPackerKind kind;
+    SP_Ivec2 size;
+    union {
+        QuadtreeAtlas quadtree;
+        SkylineAtlas skyline;
+    } packer;
+
+    u32 glyph_count;
+    u64 glyph_area;
+};
+
+static AtlasPacker atlas_packer_init(SP_Arena* arena, RNE_AtlasPackerKind kind, SP_Ivec2 size) {
+    AtlasPacker atlas = {
+        .kind = kind,
+        .size = size,
+    };
+    switch (kind) {
+        case RNE_ATLAS_PACKER_QUADTREE:
+            atlas.packer.quadtree = quadtree_atlas_init(arena, size);
+            break;
+        case RNE_ATLAS_PACKER_SKYLINE:
+            atlas.packer.skyline = skyline_atlas_init(arena, size);
+            break;
+    }
+    return atlas;
+}
+
+// Returns false when the atlas is out of space.
+static b8 atlas_packer_insert(AtlasPacker* atlas, SP_Ivec2 size, SP_Ivec2* pos) {
+    // Empty glyphs such as spaces never get sampled.
+    if (size.x == 0 || size.y == 0) {
+        *pos = sp_iv2(0, 0);
+        return true;
+    }
+
+    b8 inserted = false;
+    switch (atlas->kind) {
+        case RNE_ATLAS_PACKER_QUADTREE: {
+            QuadtreeAtlasNode* node = quadtree_atlas_insert(&atlas->packer.quadtree, size);
+            if (node != NULL) {
+                *pos = node->pos;
+                inserted = true;
+            }
+        } break;
+        case RNE_ATLAS_PACKER_SKYLINE:
+            inserted = skyline_atlas_insert(&atlas->packer.skyline, size, pos);
+            break;
+    }
+
+    if (inserted) {
+        atlas->glyph_count++;
+        atlas->glyph_area += (u64) size.x * size.y;
+    }
+    return inserted;
+}
+
+static void atlas_packer_reset(AtlasPacker* atlas) {
+    switch (atlas->kind) {
+        case RNE_ATLAS_PACKER_QUADTREE:
+            quadtree_atlas_reset(&atlas->packer.quadtree);
+            break;
+        case RNE_ATLAS_PACKER_SKYLINE:
+            skyline_atlas_reset(&atlas->packer.skyline);
+            break;
+    }
+    atlas->glyph_count = 0;
+    atlas->glyph_area = 0;
+}
+
+// Area the packer can no longer hand out, glyphs and waste alike.
+static u64 atlas_packer_used_area(const AtlasPacker* atlas) {
+    u64 free_area = 0;
+    switch (atlas->kind) {
+        case RNE_ATLAS_PACKER_QUADTREE:
+            free_area = quadtree_atlas_free_area(&atlas->packer.quadtree.root);
+            break;
+        case RNE_ATLAS_PACKER_SKYLINE:
+            free_area = skyline_atlas_free_area(&atlas->packer.skyline);
+            break;
+    }
+    return (u64) atlas->size.x * atlas->size.y - free_area;
 }
 
 // -- Font provider ------------------------------------------------------------
@@ -148,8 +423,12 @@ struct FontProvider {
     void (*terminate)(void* internal);
     u32 (*get_glyph_index)(void* internal, u32 codepoint);
     FPGlyph (*get_glyph)(void* internal, SP_Arena* arena, u32 glyph_index, f32 size);
+    // Same advance as 'get_glyph' without rasterizing anything.
+    f32 (*get_advance)(void* internal, u32 glyph_index, f32 size);
     RNE_FontMetrics (*get_metrics)(void* internal, f32 size);
     i32 (*get_kerning)(void* internal, u32 left_glyph, u32 right_glyph, f32 size);
+    // False if the font has no kerning data, every pair would kern by 0.
+    b8 (*has_kerning)(void* internal);
 };
 
 // -- stb_truetype font provider -----------------------------------------------
@@ -208,6 +487,15 @@ static FPGlyph fp_stbtt_get_glyph(void* internal, SP_Arena* arena, u32 glyph_ind
     return glyph;
 }
 
+static f32 fp_stbtt_get_advance(void* internal, u32 glyph_index, f32 size) {
+    STBTTInternal* stbtt = internal;
+    i32 advance;
+    i32 lsb;
+    stbtt_GetGlyphHMetrics(&stbtt->info, glyph_index, &advance, &lsb);
+    f32 scale = stbtt_ScaleForPixelHeight(&stbtt->info, size);
+    return floorf(advance * scale);
+}
+
 static RNE_FontMetrics fp_stbtt_get_metrics(void* internal, f32 size) {
     STBTTInternal* stbtt = internal;
     f32 scale = stbtt_ScaleForPixelHeight(&stbtt->info, size);
@@ -229,43 +517,152 @@ static i32 fp_stbtt_get_kerning(void* internal, u32 left_glyph, u32 right_glyph,
     return floorf(kern * scale);
 }
 
+static b8 fp_stbtt_has_kerning(void* internal) {
+    STBTTInternal* stbtt = internal;
+    return stbtt->info.kern != 0 || stbtt->info.gpos != 0;
+}
+
 static const FontProvider STBTT_PROVIDER = {
     .init = fp_stbtt_init,
     .terminate = fp_stbtt_terminate,
     .get_glyph_index = fp_stbtt_get_glyph_index,
     .get_glyph = fp_stbtt_get_glyph,
+    .get_advance = fp_stbtt_get_advance,
     .get_metrics = fp_stbtt_get_metrics,
     .get_kerning = fp_stbtt_get_kerning,
+    .has_kerning = fp_stbtt_has_kerning,
 };
 
 // -- User API -----------------------------------------------------------------
 
-typedef struct RNE_GlyphInternal RNE_GlyphInternal;
-struct RNE_GlyphInternal {
-    RNE_Glyph user_glyph;
-    u8* bitmap;
-    SP_Ivec2 bitmap_size;
+// Codepoints are looked up through a three level table. The high bits select
+// a Unicode plane, the middle bits a page within it and the low bits a slot,
+// so a lookup is three array indexes. Plane directories and pages are
+// allocated the first time one of their codepoints is requested, so a sized
+// font that's only measured in ASCII stays small.
+#define CODEPOINT_COUNT 0x110000
+#define GLYPH_PAGE_BITS 8
+#define GLYPH_PAGE_SIZE (1 << GLYPH_PAGE_BITS)
+#define GLYPH_PLANE_BITS 16
+#define GLYPH_PLANE_COUNT (CODEPOINT_COUNT >> GLYPH_PLANE_BITS)
+#define GLYPH_PLANE_PAGE_COUNT (1 << (GLYPH_PLANE_BITS - GLYPH_PAGE_BITS))
+
+// Rasterized glyphs are kept in the same kind of table, indexed by glyph
+// index instead. Codepoints sharing a glyph, like every codepoint the font
+// lacks, then share a single copy in the atlas. TrueType glyph indices are
+// 16-bit.
+#define GLYPH_INDEX_COUNT 0x10000
+#define RASTER_PAGE_COUNT (GLYPH_INDEX_COUNT / GLYPH_PAGE_SIZE)
+
+typedef struct AtlasPage AtlasPage;
+
+typedef struct RasterSlot RasterSlot;
+struct RasterSlot {
+    RNE_Glyph glyph;
+    b8 rasterized;
+    // Page the glyph was packed into and its generation at the time. The
+    // glyph is stale once the page has been evicted since.
+    AtlasPage* atlas_page;
+    u32 atlas_generation;
 };
 
-// Printable ASCII characters
+typedef struct RasterPage RasterPage;
+struct RasterPage {
+    RasterSlot slots[GLYPH_PAGE_SIZE];
+};
+
+typedef enum GlyphSlotFlag {
+    GLYPH_SLOT_FLAG_INDEX = 1 << 0,
+    GLYPH_SLOT_FLAG_ADVANCE = 1 << 1,
+} GlyphSlotFlag;
+
+typedef struct GlyphSlot GlyphSlot;
+struct GlyphSlot {
+    u32 glyph_index;
+    f32 advance;
+    GlyphSlotFlag flags;
+    // Slot of 'glyph_index', NULL until the glyph is first requested.
+    RasterSlot* raster;
+};
+
+typedef struct GlyphPage GlyphPage;
+struct GlyphPage {
+    GlyphSlot slots[GLYPH_PAGE_SIZE];
+};
+
+// Printable ASCII characters, kerned through a dense matrix.
 // https://www.ascii-code.com/
 #define ASCII_START 32
-#define ASCII_END 127
+#define ASCII_END 126
 #define ASCII_COUNT (ASCII_END - ASCII_START + 1)
 
+typedef struct RNE_Font RNE_Font;
+
+// Glyphs never move once packed. When every page is full a new one is added
+// instead of repacking, so only the new page has to be uploaded. With a budget
+// the least recently used page is emptied and reused instead once the budget
+// is reached, which bumps its generation.
+struct AtlasPage {
+    AtlasPage* next;
+    AtlasPacker packer;
+    RNE_UserData userdata;
+    // CPU copy of the page, a byte per pixel. NULL unless the atlas keeps one.
+    u8* pixels;
+    u32 generation;
+    // Frame a glyph on the page was last handed out in.
+    u64 last_used;
+};
+
+#define ATLAS_PAGE_INITIAL_SIZE 256
+#define ATLAS_PAGE_MAX_SIZE 2048
+
+// Every sized font owns one of these, unless its font was created with a
+// shared atlas from 'rne_font_atlas_create' which all of them pack into.
+typedef struct Atlas Atlas;
+struct Atlas {
+    SP_Arena* arena;
+    RNE_FontCallbacks cb;
+    RNE_AtlasPackerKind packer_kind;
+    b8 cpu_mirror;
+    // Newest first. The first page is only created once a glyph is packed, so
+    // sizes that are only measured never get one.
+    AtlasPage* pages;
+
+    // Zero for no budget.
+    u64 budget_bytes;
+    // Sum of the page areas, at a byte per pixel.
+    u64 bytes;
+    u64 frame;
+    u32 eviction_count;
+};
+
+// Handed out by 'rne_font_sized', so it must never move once created.
 typedef struct RNE_SizedFont RNE_SizedFont;
 struct RNE_SizedFont {
+    RNE_Font* font;
     f32 size;
-    QuadtreeAtlas atlas_packer;
-    RNE_UserData userdata_atlas;
-    // Key: u32 (glyph index)
-    // Value: RNE_GlyphInternal
-    SP_HashMap* glyph_map;
-    // Keep all ASCII characters in a simple flat array to speed up queries.
-    RNE_GlyphInternal ascii_glyphs[ASCII_COUNT];
+    RNE_FontMetrics metrics;
+
+    // Points to 'own_atlas' or the shared atlas of the font.
+    Atlas* atlas;
+    Atlas own_atlas;
+
+    // GLYPH_PLANE_PAGE_COUNT pages per plane. Planes and pages are NULL until
+    // used.
+    GlyphPage** planes[GLYPH_PLANE_COUNT];
+    // RASTER_PAGE_COUNT pages, NULL until the first glyph is rasterized, as
+    // are the pages.
+    RasterPage** raster_pages;
+
+    // ASCII_COUNT * ASCII_COUNT kerning values indexed by [left][right],
+    // built on the first ASCII pair.
+    f32* ascii_kerning;
+    // Pairs with at least one non ASCII codepoint.
+    // Key: u64 (left codepoint << 32 | right codepoint)
+    // Value: f32
+    SP_HashMap* kerning_map;
 };
 
-typedef struct RNE_Font RNE_Font;
 struct RNE_Font {
     SP_Arena* arena;
     RNE_FontCallbacks cb;
@@ -273,23 +670,258 @@ struct RNE_Font {
     FontProvider provider;
 
     void* internal;
+    b8 has_kerning;
+    RNE_AtlasPackerKind atlas_packer;
+    u64 atlas_budget_bytes;
+    b8 atlas_cpu_mirror;
+    // NULL unless the font was created with a shared atlas.
+    Atlas* shared_atlas;
     // Key: f32 (size)
-    // Value: RNE_SizedFont
+    // Value: RNE_SizedFont*
     SP_HashMap* map;
 };
 
-static RNE_SizedFont sized_font_create(RNE_Font* font, f32 size) {
-    SP_Ivec2 atlas_size = sp_iv2(256, 256);
-    RNE_SizedFont sized = {
+static RNE_SizedFont* sized_font_create(RNE_Font* font, f32 size) {
+    RNE_SizedFont* sized = sp_arena_push_no_zero(font->arena, sizeof(RNE_SizedFont));
+    *sized = (RNE_SizedFont) {
+        .font = font,
         .size = size,
-        .atlas_packer = quadtree_atlas_init(font->arena, atlas_size),
-        .userdata_atlas = font->cb.create(atlas_size),
-        .glyph_map = sp_hash_map_create(sp_hash_map_desc_generic(sp_arena_allocator(font->arena), 32, SP_HASH_COLLISION_RESOLUTION_SEPARATE_CHAINING, u32, RNE_GlyphInternal)),
+        .metrics = font->provider.get_metrics(font->internal, size),
+        .kerning_map = sp_hash_map_create(sp_hash_map_desc_generic(sp_arena_allocator(font->arena), 32, SP_HASH_COLLISION_RESOLUTION_SEPARATE_CHAINING, u64, f32)),
+        .own_atlas = {
+            .arena = font->arena,
+            .cb = font->cb,
+            .packer_kind = font->atlas_packer,
+            .budget_bytes = font->atlas_budget_bytes,
+            .cpu_mirror = font->atlas_cpu_mirror,
+        },
     };
+    sized->atlas = font->shared_atlas != NULL ? font->shared_atlas : &sized->own_atlas;
     return sized;
 }
 
-RNE_Handle rne_font_create(SP_Arena* arena, SP_Str ttf_data, RNE_FontCallbacks callbacks) {
+// Each page is twice the size of the previous one up to ATLAS_PAGE_MAX_SIZE,
+// or larger if that's what it takes to fit a glyph of 'min_size'. Near the
+// budget pages get smaller again, down to ATLAS_PAGE_INITIAL_SIZE.
+static i32 atlas_next_page_size(const Atlas* atlas, SP_Ivec2 min_size) {
+    // Leave room for the packers padding and alignment.
+    i32 min = sp_max(min_size.x, min_size.y) + 4;
+
+    i32 size = ATLAS_PAGE_INITIAL_SIZE;
+    if (atlas->pages != NULL) {
+        size = sp_max(atlas->pages->packer.size.x, sp_min(atlas->pages->packer.size.x * 2, ATLAS_PAGE_MAX_SIZE));
+    }
+    while (size < min) {
+        size *= 2;
+    }
+
+    if (atlas->budget_bytes > 0) {
+        while (size / 2 >= sp_max(min, ATLAS_PAGE_INITIAL_SIZE) &&
+                atlas->bytes + (u64) size * size > atlas->budget_bytes) {
+            size /= 2;
+        }
+    }
+    return size;
+}
+
+static AtlasPage* atlas_page_push(Atlas* atlas, i32 size) {
+    AtlasPage* page = sp_arena_push_no_zero(atlas->arena, sizeof(AtlasPage));
+    *page = (AtlasPage) {
+        .next = atlas->pages,
+        .packer = atlas_packer_init(atlas->arena, atlas->packer_kind, sp_iv2(size, size)),
+        .userdata = atlas->cb.create(sp_iv2(size, size)),
+        .last_used = atlas->frame,
+    };
+    if (atlas->cpu_mirror) {
+        page->pixels = sp_arena_push(atlas->arena, (u64) size * size);
+    }
+    atlas->pages = page;
+    atlas->bytes += (u64) size * size;
+    return page;
+}
+
+// Uploads the whole page from its mirror.
+static void atlas_page_upload(Atlas* atlas, AtlasPage* page) {
+    atlas->cb.update(page->userdata, sp_iv2(0, 0), page->packer.size, page->packer.size.x, page->pixels);
+}
+
+static void atlas_page_write(Atlas* atlas, AtlasPage* page, SP_Ivec2 pos, SP_Ivec2 size, const u8* pixels) {
+    if (page->pixels != NULL) {
+        for (i32 y = 0; y < size.y; y++) {
+            memcpy(&page->pixels[(pos.y + y) * page->packer.size.x + pos.x], &pixels[y * size.x], size.x);
+        }
+    }
+    atlas->cb.update(page->userdata, pos, size, size.x, pixels);
+}
+
+// Zeroes the texture of an evicted page. Stale glyphs would otherwise bleed
+// into the padding around the glyphs packed next.
+static void atlas_page_clear(Atlas* atlas, AtlasPage* page) {
+    u64 area = (u64) page->packer.size.x * page->packer.size.y;
+    if (page->pixels != NULL) {
+        memset(page->pixels, 0, area);
+        atlas_page_upload(atlas, page);
+        return;
+    }
+    SP_Scratch scratch = sp_scratch_begin(&atlas->arena, 1);
+    u8* zero = sp_arena_push(scratch.arena, area);
+    atlas->cb.update(page->userdata, sp_iv2(0, 0), page->packer.size, page->packer.size.x, zero);
+    sp_scratch_end(scratch);
+}
+
+static AtlasPage* atlas_newest_page(Atlas* atlas) {
+    if (atlas->pages == NULL) {
+        atlas_page_push(atlas, atlas_next_page_size(atlas, sp_iv2(0, 0)));
+    }
+    return atlas->pages;
+}
+
+// Empties the least recently used page that is large enough for a glyph of
+// 'min_size'. Pages used during the current frame are never evicted since
+// their glyphs may already be referenced by its vertices. Returns NULL if no
+// page qualifies.
+static AtlasPage* atlas_evict(Atlas* atlas, SP_Ivec2 min_size) {
+    i32 min = sp_max(min_size.x, min_size.y) + 4;
+    AtlasPage* lru = NULL;
+    for (AtlasPage* page = atlas->pages; page != NULL; page = page->next) {
+        if (page->last_used >= atlas->frame || page->packer.size.x < min) {
+            continue;
+        }
+        if (lru == NULL || page->last_used < lru->last_used) {
+            lru = page;
+        }
+    }
+    if (lru == NULL) {
+        return NULL;
+    }
+
+    atlas_packer_reset(&lru->packer);
+    atlas_page_clear(atlas, lru);
+    lru->generation++;
+    atlas->eviction_count++;
+    return lru;
+}
+
+// Packs a glyph into the first page with room for it. If none has any, a new
+// page is added, or an old one is evicted when a new page would exceed the
+// budget. The budget is exceeded if every page is still in use.
+static AtlasPage* atlas_insert(Atlas* atlas, SP_Ivec2 size, SP_Ivec2* pos) {
+    for (AtlasPage* page = atlas->pages; page != NULL; page = page->next) {
+        if (atlas_packer_insert(&page->packer, size, pos)) {
+            page->last_used = atlas->frame;
+            return page;
+        }
+    }
+
+    i32 page_size = atlas_next_page_size(atlas, size);
+    AtlasPage* page = NULL;
+    if (atlas->budget_bytes > 0 && atlas->bytes + (u64) page_size * page_size > atlas->budget_bytes) {
+        page = atlas_evict(atlas, size);
+    }
+    if (page == NULL) {
+        page = atlas_page_push(atlas, page_size);
+    }
+    b8 inserted = atlas_packer_insert(&page->packer, size, pos);
+    sp_assert(inserted, "Glyph doesn't fit in an empty atlas page.");
+    page->last_used = atlas->frame;
+    return page;
+}
+
+static void atlas_destroy(Atlas* atlas) {
+    for (AtlasPage* page = atlas->pages; page != NULL; page = page->next) {
+        atlas->cb.destroy(page->userdata);
+    }
+    atlas->pages = NULL;
+}
+
+static void atlas_reupload(Atlas* atlas) {
+    for (AtlasPage* page = atlas->pages; page != NULL; page = page->next) {
+        if (page->pixels != NULL) {
+            atlas_page_upload(atlas, page);
+        }
+    }
+}
+
+static RNE_AtlasStats atlas_stats(const Atlas* atlas) {
+    RNE_AtlasStats stats = {0};
+    for (AtlasPage* page = atlas->pages; page != NULL; page = page->next) {
+        stats.page_count++;
+        stats.area += (u64) page->packer.size.x * page->packer.size.y;
+        stats.glyph_count += page->packer.glyph_count;
+        stats.glyph_area += page->packer.glyph_area;
+        stats.used_area += atlas_packer_used_area(&page->packer);
+        if (page->pixels != NULL) {
+            stats.mirror_bytes += (u64) page->packer.size.x * page->packer.size.y;
+        }
+    }
+    stats.eviction_count = atlas->eviction_count;
+    if (stats.area > 0) {
+        stats.occupancy = (f32) stats.glyph_area / stats.area;
+    }
+    if (stats.used_area > 0) {
+        stats.fragmentation = 1.0f - (f32) stats.glyph_area / stats.used_area;
+    }
+    return stats;
+}
+
+RNE_Handle rne_font_atlas_create(SP_Arena* arena, RNE_FontAtlasConfig config) {
+    Atlas* atlas = sp_arena_push_no_zero(arena, sizeof(Atlas));
+    *atlas = (Atlas) {
+        .arena = arena,
+        .cb = config.callbacks,
+        .packer_kind = config.atlas_packer,
+        .budget_bytes = config.budget_bytes,
+        .cpu_mirror = config.cpu_mirror,
+    };
+    return (RNE_Handle) {
+        .ptr = atlas,
+    };
+}
+
+void rne_font_atlas_destroy(RNE_Handle* atlas) {
+    atlas_destroy(atlas->ptr);
+}
+
+RNE_Handle rne_font_atlas_get_page(RNE_Handle atlas) {
+    return atlas_newest_page(atlas.ptr)->userdata;
+}
+
+RNE_AtlasStats rne_font_atlas_stats(RNE_Handle atlas) {
+    return atlas_stats(atlas.ptr);
+}
+
+void rne_font_atlas_reupload(RNE_Handle atlas) {
+    atlas_reupload(atlas.ptr);
+}
+
+void rne_font_atlas_end_frame(RNE_Handle atlas) {
+    Atlas* _atlas = atlas.ptr;
+    _atlas->frame++;
+}
+
+// Slot of a codepoint with its glyph index resolved.
+static GlyphSlot* get_glyph_slot(RNE_Font* font, RNE_SizedFont* sized, u32 codepoint) {
+    if (codepoint >= CODEPOINT_COUNT) {
+        codepoint = RNE_CODEPOINT_INVALID;
+    }
+
+    GlyphPage*** plane = &sized->planes[codepoint >> GLYPH_PLANE_BITS];
+    if (*plane == NULL) {
+        *plane = sp_arena_push(font->arena, sizeof(GlyphPage*) * GLYPH_PLANE_PAGE_COUNT);
+    }
+    GlyphPage** page = &(*plane)[(codepoint >> GLYPH_PAGE_BITS) & (GLYPH_PLANE_PAGE_COUNT - 1)];
+    if (*page == NULL) {
+        *page = sp_arena_push(font->arena, sizeof(GlyphPage));
+    }
+    GlyphSlot* slot = &(*page)->slots[codepoint & (GLYPH_PAGE_SIZE - 1)];
+    if (!(slot->flags & GLYPH_SLOT_FLAG_INDEX)) {
+        slot->glyph_index = font->provider.get_glyph_index(font->internal, codepoint);
+        slot->flags |= GLYPH_SLOT_FLAG_INDEX;
+    }
+    return slot;
+}
+
+RNE_Handle rne_font_create(SP_Arena* arena, SP_Str ttf_data, RNE_FontConfig config) {
     RNE_Font* font = sp_arena_push_no_zero(arena, sizeof(RNE_Font));
     FontProvider provider = STBTT_PROVIDER;
     *font = (RNE_Font) {
@@ -297,10 +929,16 @@ RNE_Handle rne_font_create(SP_Arena* arena, SP_Str ttf_data, RNE_FontCallbacks c
         .provider = provider,
         .internal = provider.init(arena, ttf_data),
         .ttf_data = ttf_data,
-        .map = sp_hash_map_create(sp_hash_map_desc_generic(sp_arena_allocator(arena), 32, SP_HASH_COLLISION_RESOLUTION_SEPARATE_CHAINING, f32, RNE_SizedFont)),
-        .cb = callbacks,
+        .map = sp_hash_map_create(sp_hash_map_desc_generic(sp_arena_allocator(arena), 32, SP_HASH_COLLISION_RESOLUTION_SEPARATE_CHAINING, f32, RNE_SizedFont*)),
+        .cb = config.callbacks,
+        .atlas_packer = config.atlas_packer,
+        .atlas_budget_bytes = config.atlas_budget_bytes,
+        .atlas_cpu_mirror = config.atlas_cpu_mirror,
+        .shared_atlas = config.shared_atlas.ptr,
     };
 
+    font->has_kerning = provider.has_kerning(font->internal);
+
     return (RNE_Handle) {
         .ptr = font,
     };
@@ -311,22 +949,50 @@ void rne_font_destroy(RNE_Handle* font) {
     for (SP_HashMapIter iter = sp_hash_map_iter_init(_font->map);
             sp_hash_map_iter_valid(iter);
             iter = sp_hash_map_iter_next(iter)) {
-        RNE_SizedFont sized;
+        RNE_SizedFont* sized;
         sp_hash_map_iter_get_value(iter, &sized);
-        _font->cb.destroy(sized.userdata_atlas);
+        atlas_destroy(&sized->own_atlas);
     }
 
     _font->provider.terminate(_font->internal);
 }
 
+void rne_font_reupload(RNE_Handle font) {
+    RNE_Font* _font = font.ptr;
+    for (SP_HashMapIter iter = sp_hash_map_iter_init(_font->map);
+            sp_hash_map_iter_valid(iter);
+            iter = sp_hash_map_iter_next(iter)) {
+        RNE_SizedFont* sized;
+        sp_hash_map_iter_get_value(iter, &sized);
+        atlas_reupload(&sized->own_atlas);
+    }
+}
+
+void rne_font_end_frame(RNE_Handle font) {
+    RNE_Font* _font = font.ptr;
+    for (SP_HashMapIter iter = sp_hash_map_iter_init(_font->map);
+            sp_hash_map_iter_valid(iter);
+            iter = sp_hash_map_iter_next(iter)) {
+        RNE_SizedFont* sized;
+        sp_hash_map_iter_get_value(iter, &sized);
+        sized->own_atlas.frame++;
+    }
+}
+
 static RNE_SizedFont* get_sized_font(RNE_Font* font, f32 size) {
-    RNE_SizedFont* result = sp_hash_map_getp(font->map, &size);
-    if (result == NULL) {
-        RNE_SizedFont sized = sized_font_create(font, size);
-        sp_hash_map_insert(font->map, &size, &sized);
-        result = sp_hash_map_getp(font->map, &size);
+    RNE_SizedFont** result = sp_hash_map_getp(font->map, &size);
+    if (result != NULL) {
+        return *result;
     }
-    return result;
+    RNE_SizedFont* sized = sized_font_create(font, size);
+    sp_hash_map_insert(font->map, &size, &sized);
+    return sized;
+}
+
+RNE_Handle rne_font_sized(RNE_Handle font, f32 size) {
+    return (RNE_Handle) {
+        .ptr = get_sized_font(font.ptr, size),
+    };
 }
 
 static void calculate_uvs(SP_Ivec2 pos, SP_Ivec2 size, SP_Ivec2 atlas_size, SP_Vec2 uvs[2]) {
@@ -341,133 +1007,193 @@ static void calculate_uvs(SP_Ivec2 pos, SP_Ivec2 size, SP_Ivec2 atlas_size, SP_V
     uvs[1] = uv_br;
 }
 
-static void expand_atlas(RNE_Font* font, RNE_SizedFont* sized) {
-    QuadtreeAtlas packer = quadtree_atlas_init(font->arena, sp_iv2_muls(sized->atlas_packer.size, 2));
+static f32 get_advance(RNE_Font* font, RNE_SizedFont* sized, u32 codepoint) {
+    GlyphSlot* slot = get_glyph_slot(font, sized, codepoint);
+    if (!(slot->flags & GLYPH_SLOT_FLAG_ADVANCE)) {
+        slot->advance = font->provider.get_advance(font->internal, slot->glyph_index, sized->size);
+        slot->flags |= GLYPH_SLOT_FLAG_ADVANCE;
+    }
+    return slot->advance;
+}
 
-    SP_Scratch scratch = sp_scratch_begin(&font->arena, 1);
-    u8* bitmap = sp_arena_push(scratch.arena, packer.size.x * packer.size.y);
+static f32 lookup_kerning(RNE_Font* font, RNE_SizedFont* sized, u32 left_codepoint, u32 right_codepoint) {
+    u32 left_glyph = get_glyph_slot(font, sized, left_codepoint)->glyph_index;
+    u32 right_glyph = get_glyph_slot(font, sized, right_codepoint)->glyph_index;
+    return font->provider.get_kerning(font->internal, left_glyph, right_glyph, sized->size);
+}
 
-    // Iterate ascii characters
-    for (u8 i = 0; i < ASCII_COUNT; i++) {
-        RNE_GlyphInternal* glyph = &sized->ascii_glyphs[i];
-        // Character hasn't been cached yet.
-        if (glyph->bitmap == NULL) {
-            continue;
-        }
+static b8 is_ascii(u32 codepoint) {
+    return codepoint >= ASCII_START && codepoint <= ASCII_END;
+}
 
-        QuadtreeAtlasNode* node = quadtree_atlas_insert(&packer, glyph->bitmap_size);
-        for (i32 y = 0; y < glyph->bitmap_size.y; y++) {
-            u32 atlas_index = node->pos.x + (node->pos.y + y) * packer.size.x;
-            u32 glyph_index = y * glyph->bitmap_size.x;
-            memcpy(&bitmap[atlas_index], &glyph->bitmap[glyph_index], glyph->bitmap_size.x);
-        }
-        calculate_uvs(node->pos, node->size, packer.size, glyph->user_glyph.uv);
+static f32 get_kerning(RNE_Font* font, RNE_SizedFont* sized, u32 left_codepoint, u32 right_codepoint) {
+    if (!font->has_kerning) {
+        return 0.0f;
     }
 
-    SP_HashMapIter iter = sp_hash_map_iter_init(sized->glyph_map);
-    while (sp_hash_map_iter_valid(iter)) {
-        RNE_GlyphInternal* glyph = sp_hash_map_iter_get_valuep(iter);
-        QuadtreeAtlasNode* node = quadtree_atlas_insert(&packer, glyph->bitmap_size);
-        for (i32 y = 0; y < glyph->bitmap_size.y; y++) {
-            u32 atlas_index = node->pos.x + (node->pos.y + y) * packer.size.x;
-            u32 glyph_index = y * glyph->bitmap_size.x;
-            memcpy(&bitmap[atlas_index], &glyph->bitmap[glyph_index], glyph->bitmap_size.x);
+    if (is_ascii(left_codepoint) && is_ascii(right_codepoint)) {
+        if (sized->ascii_kerning == NULL) {
+            sized->ascii_kerning = sp_arena_push_no_zero(font->arena, sizeof(f32) * ASCII_COUNT * ASCII_COUNT);
+            for (u32 left = 0; left < ASCII_COUNT; left++) {
+                for (u32 right = 0; right < ASCII_COUNT; right++) {
+                    sized->ascii_kerning[left * ASCII_COUNT + right] = lookup_kerning(font, sized, ASCII_START + left, ASCII_START + right);
+                }
+            }
         }
-        calculate_uvs(node->pos, node->size, packer.size, glyph->user_glyph.uv);
-
-        iter = sp_hash_map_iter_next(iter);
+        return sized->ascii_kerning[(left_codepoint - ASCII_START) * ASCII_COUNT + (right_codepoint - ASCII_START)];
     }
 
-    font->cb.resize(sized->userdata_atlas, packer.size, bitmap);
-    sp_scratch_end(scratch);
-
-    sized->atlas_packer = packer;
+    u64 key = (u64) left_codepoint << 32 | right_codepoint;
+    f32* cached = sp_hash_map_getp(sized->kerning_map, &key);
+    if (cached != NULL) {
+        return *cached;
+    }
+    f32 kerning = lookup_kerning(font, sized, left_codepoint, right_codepoint);
+    sp_hash_map_insert(sized->kerning_map, &key, &kerning);
+    return kerning;
 }
 
-SP_Vec2 rne_text_measure(RNE_Handle font, SP_Str text, f32 size) {
-    RNE_FontMetrics metrics = rne_font_get_metrics(font, size);
+// Only uses glyph metrics, so measuring never rasterizes glyphs or touches
+// the atlas.
+SP_Vec2 rne_sized_text_measure(RNE_Handle sized_font, SP_Str text) {
+    RNE_SizedFont* sized = sized_font.ptr;
+    RNE_Font* _font = sized->font;
+    RNE_FontMetrics metrics = sized->metrics;
     SP_Vec2 text_size = sp_v2(0.0f, metrics.ascent - metrics.descent);
-    for (u32 i = 0; i < text.len; i++) {
-        RNE_Glyph glyph = rne_font_get_glyph(font, text.data[i], size);
-        text_size.x += glyph.advance;
-        if (i < text.len - 1) {
-            text_size.x += rne_font_get_kerning(font, text.data[i], text.data[i+1], size);
+    u32 offset = 0;
+    while (offset < text.len) {
+        u32 codepoint = rne_utf8_decode(text, &offset);
+        text_size.x += get_advance(_font, sized, codepoint);
+        if (offset < text.len) {
+            u32 next_offset = offset;
+            u32 next = rne_utf8_decode(text, &next_offset);
+            text_size.x += get_kerning(_font, sized, codepoint, next);
         }
     }
     return text_size;
 }
 
-RNE_Glyph rne_font_get_glyph(RNE_Handle font, u32 codepoint, f32 size) {
-    RNE_Font* _font = font.ptr;
-    RNE_SizedFont* sized = get_sized_font(_font, size);
-
-    b8 is_ascii = false;
-    u32 glyph_index = _font->provider.get_glyph_index(_font->internal, codepoint);
-    if (codepoint >= ASCII_START && codepoint <= ASCII_END) {
-        is_ascii = true;
-        u32 index = codepoint - ASCII_START;
-        RNE_GlyphInternal glyph = sized->ascii_glyphs[index];
-        if (glyph.bitmap != NULL) {
-            return glyph.user_glyph;
-        }
-    } else {
-        RNE_Glyph* _glyph = sp_hash_map_getp(sized->glyph_map, &glyph_index);
-        if (_glyph != NULL) {
-            return *_glyph;
+static RasterSlot* get_raster_slot(RNE_Font* font, RNE_SizedFont* sized, u32 glyph_index) {
+    sp_assert(glyph_index < GLYPH_INDEX_COUNT, "Glyph index out of range.");
+    if (sized->raster_pages == NULL) {
+        sized->raster_pages = sp_arena_push(font->arena, sizeof(RasterPage*) * RASTER_PAGE_COUNT);
+    }
+    RasterPage** page = &sized->raster_pages[glyph_index >> GLYPH_PAGE_BITS];
+    if (*page == NULL) {
+        *page = sp_arena_push(font->arena, sizeof(RasterPage));
+    }
+    return &(*page)->slots[glyph_index & (GLYPH_PAGE_SIZE - 1)];
+}
+
+static RNE_Glyph get_glyph(RNE_SizedFont* sized, u32 codepoint) {
+    RNE_Font* _font = sized->font;
+    GlyphSlot* slot = get_glyph_slot(_font, sized, codepoint);
+    if (slot->raster == NULL) {
+        slot->raster = get_raster_slot(_font, sized, slot->glyph_index);
+    }
+    RasterSlot* raster = slot->raster;
+    if (raster->rasterized && raster->atlas_page->generation == raster->atlas_generation) {
+        // Only the first hit on a page in a frame writes, so hits on glyphs
+        // requested earlier in the frame stay read-only. Parallel
+        // tessellation relies on that.
+        if (raster->atlas_page->last_used != sized->atlas->frame) {
+            raster->atlas_page->last_used = sized->atlas->frame;
         }
+        return raster->glyph;
     }
 
     SP_Scratch scratch = sp_scratch_begin(&_font->arena, 1);
-    FPGlyph fp_glyph = _font->provider.get_glyph(_font->internal, scratch.arena, glyph_index, size);
-    u32 bitmap_size = fp_glyph.bitmap.size.x * fp_glyph.bitmap.size.y;
-    u8* bitmap = sp_arena_push(_font->arena, bitmap_size);
-    memcpy(bitmap, fp_glyph.bitmap.buffer, bitmap_size);
-    sp_scratch_end(scratch);
+    FPGlyph fp_glyph = _font->provider.get_glyph(_font->internal, scratch.arena, slot->glyph_index, sized->size);
 
-    QuadtreeAtlasNode* node = quadtree_atlas_insert(&sized->atlas_packer, fp_glyph.bitmap.size);
-    // Atlas out of space.
-    while (node == NULL) {
-        expand_atlas(_font, sized);
-        node = quadtree_atlas_insert(&sized->atlas_packer, fp_glyph.bitmap.size);
+    SP_Ivec2 pos;
+    AtlasPage* page = atlas_insert(sized->atlas, fp_glyph.bitmap.size, &pos);
+    if (fp_glyph.bitmap.size.x > 0 && fp_glyph.bitmap.size.y > 0) {
+        atlas_page_write(sized->atlas, page, pos, fp_glyph.bitmap.size, fp_glyph.bitmap.buffer);
     }
+    sp_scratch_end(scratch);
 
-    _font->cb.update(sized->userdata_atlas, node->pos, fp_glyph.bitmap.size, sized->atlas_packer.size.x, bitmap);
+    RNE_Glyph glyph = {
+        .size = fp_glyph.size,
+        .offset = fp_glyph.offset,
+        .advance = fp_glyph.advance,
+        .atlas = page->userdata,
+    };
+    calculate_uvs(pos, fp_glyph.bitmap.size, page->packer.size, glyph.uv);
 
-    RNE_GlyphInternal glyph = {
-        .user_glyph = {
-            .size = fp_glyph.size,
-            .offset = fp_glyph.offset,
-            .advance = fp_glyph.advance,
-        },
-        .bitmap_size = fp_glyph.bitmap.size,
-        .bitmap = bitmap,
+    *raster = (RasterSlot) {
+        .glyph = glyph,
+        .rasterized = true,
+        .atlas_page = page,
+        .atlas_generation = page->generation,
     };
-    calculate_uvs(node->pos, sp_v2_to_iv2(fp_glyph.size), sized->atlas_packer.size, glyph.user_glyph.uv);
+    slot->advance = glyph.advance;
+    slot->flags |= GLYPH_SLOT_FLAG_ADVANCE;
+    return glyph;
+}
+
+RNE_Glyph rne_sized_font_get_glyph(RNE_Handle sized_font, u32 codepoint) {
+    return get_glyph(sized_font.ptr, codepoint);
+}
 
-    if (is_ascii) {
-        sized->ascii_glyphs[codepoint - ASCII_START] = glyph;
-    } else {
-        sp_debug("NON ASCII!!!");
-        sp_hash_map_insert(sized->glyph_map, &glyph_index, &glyph);
+u32 rne_sized_font_layout_run(RNE_Handle sized_font, SP_Str text, SP_Vec2* out_positions, RNE_Glyph* out_glyphs) {
+    RNE_SizedFont* sized = sized_font.ptr;
+    u32 count = 0;
+    f32 pen = 0.0f;
+    u32 prev = 0;
+    for (u32 offset = 0; offset < text.len;) {
+        u32 codepoint = rne_utf8_decode(text, &offset);
+        if (count > 0) {
+            pen += get_kerning(sized->font, sized, prev, codepoint);
+        }
+        out_positions[count] = sp_v2(pen, 0.0f);
+        out_glyphs[count] = get_glyph(sized, codepoint);
+        pen += out_glyphs[count].advance;
+        prev = codepoint;
+        count++;
     }
+    return count;
+}
 
-    return glyph.user_glyph;
+RNE_Handle rne_sized_font_get_atlas(RNE_Handle sized_font) {
+    RNE_SizedFont* sized = sized_font.ptr;
+    return atlas_newest_page(sized->atlas)->userdata;
+}
+
+RNE_FontMetrics rne_sized_font_get_metrics(RNE_Handle sized_font) {
+    RNE_SizedFont* sized = sized_font.ptr;
+    return sized->metrics;
+}
+
+f32 rne_sized_font_get_kerning(RNE_Handle sized_font, u32 left_codepoint, u32 right_codepoint) {
+    RNE_SizedFont* sized = sized_font.ptr;
+    return get_kerning(sized->font, sized, left_codepoint, right_codepoint);
+}
+
+RNE_AtlasStats rne_sized_font_atlas_stats(RNE_Handle sized_font) {
+    RNE_SizedFont* sized = sized_font.ptr;
+    return atlas_stats(sized->atlas);
+}
+
+SP_Vec2 rne_text_measure(RNE_Handle font, SP_Str text, f32 size) {
+    return rne_sized_text_measure(rne_font_sized(font, size), text);
+}
+
+RNE_Glyph rne_font_get_glyph(RNE_Handle font, u32 codepoint, f32 size) {
+    return rne_sized_font_get_glyph(rne_font_sized(font, size), codepoint);
+}
+
+u32 rne_font_layout_run(RNE_Handle font, f32 size, SP_Str text, SP_Vec2* out_positions, RNE_Glyph* out_glyphs) {
+    return rne_sized_font_layout_run(rne_font_sized(font, size), text, out_positions, out_glyphs);
 }
 
 RNE_Handle rne_font_get_atlas(RNE_Handle font, f32 size) {
-    RNE_Font* _font = font.ptr;
-    RNE_SizedFont* sized = get_sized_font(_font, size);
-    return sized->userdata_atlas;
+    return rne_sized_font_get_atlas(rne_font_sized(font, size));
 }
 
 RNE_FontMetrics rne_font_get_metrics(RNE_Handle font, f32 size) {
-    RNE_Font* _font = font.ptr;
-    return _font->provider.get_metrics(_font->internal, size);
+    return rne_sized_font_get_metrics(rne_font_sized(font, size));
 }
 
 f32 rne_font_get_kerning(RNE_Handle font, u32 left_codepoint, u32 right_codepoint, f32 size) {
-    RNE_Font* _font = font.ptr;
-    u32 left_glyph = _font->provider.get_glyph_index(_font->internal, left_codepoint);
-    u32 right_glyph = _font->provider.get_glyph_index(_font->internal, right_codepoint);
-    return _font->provider.get_kerning(_font->internal, left_glyph, right_glyph, size);
+    return rne_sized_font_get_kerning(rne_font_sized(font, size), left_codepoint, right_codepoint);
 }
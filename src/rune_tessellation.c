@@ -1,59 +1,265 @@
 #include "rune/rune_tessellation.h"
 #include "spire.h"
 
+#include <string.h>
+
 #define PI 3.14159265358979323846
 
+// SIMD kernels only cover arc points and stroke normals, in SSE2 and NEON.
+// Both are part of the x86-64 and AArch64 baselines, so the kernels are picked
+// at compile time. There is no AVX2 path and no runtime dispatch. Define
+// RUNE_NO_SIMD to force the scalar fallback.
+#if !defined(RUNE_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define RUNE_SIMD_SSE2 1
+#include <emmintrin.h>
+#elif !defined(RUNE_NO_SIMD) && defined(__ARM_NEON) && defined(__aarch64__)
+#define RUNE_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Points generated per 'arc_unit_points' call. Multiple of the SIMD width.
+#define ARC_CHUNK 64
+
+// Writes 'count' points on the unit circle, starting at angle 'start' and
+// stepping by 'step'. Output arrays must fit 'count' rounded up to a multiple
+// of 4.
+//
+// https://en.wikipedia.org/wiki/List_of_trigonometric_identities#Angle_sum_and_difference_identities
+// sin(a + b) = sin(a)*cos(b) + cos(a)*sin(b)
+// cos(a + b) = cos(a)*cos(b) - sin(a)*sin(b)
+static void arc_unit_points(f32 start, f32 step, u32 count, f32* cos_out, f32* sin_out) {
+#if defined(RUNE_SIMD_SSE2) || defined(RUNE_SIMD_NEON)
+    // Four lanes, each rotated by four steps per iteration. This breaks the
+    // serial dependency of the scalar recurrence.
+    f32 lane_cos[4];
+    f32 lane_sin[4];
+    for (u8 i = 0; i < 4; i++) {
+        lane_cos[i] = cosf(start + step * i);
+        lane_sin[i] = sinf(start + step * i);
+    }
+    f32 cosb = cosf(step * 4.0f);
+    f32 sinb = sinf(step * 4.0f);
+
+#if defined(RUNE_SIMD_SSE2)
+    __m128 c = _mm_loadu_ps(lane_cos);
+    __m128 s = _mm_loadu_ps(lane_sin);
+    __m128 vcosb = _mm_set1_ps(cosb);
+    __m128 vsinb = _mm_set1_ps(sinb);
+    for (u32 i = 0; i < count; i += 4) {
+        _mm_storeu_ps(&cos_out[i], c);
+        _mm_storeu_ps(&sin_out[i], s);
+        __m128 new_s = _mm_add_ps(_mm_mul_ps(s, vcosb), _mm_mul_ps(c, vsinb));
+        __m128 new_c = _mm_sub_ps(_mm_mul_ps(c, vcosb), _mm_mul_ps(s, vsinb));
+        s = new_s;
+        c = new_c;
+    }
+#else
+    float32x4_t c = vld1q_f32(lane_cos);
+    float32x4_t s = vld1q_f32(lane_sin);
+    for (u32 i = 0; i < count; i += 4) {
+        vst1q_f32(&cos_out[i], c);
+        vst1q_f32(&sin_out[i], s);
+        float32x4_t new_s = vmlaq_n_f32(vmulq_n_f32(s, cosb), c, sinb);
+        float32x4_t new_c = vmlsq_n_f32(vmulq_n_f32(c, cosb), s, sinb);
+        s = new_s;
+        c = new_c;
+    }
+#endif
+#else
+    f32 current_cos = cosf(start);
+    f32 current_sin = sinf(start);
+    f32 cosb = cosf(step);
+    f32 sinb = sinf(step);
+    for (u32 i = 0; i < count; i++) {
+        cos_out[i] = current_cos;
+        sin_out[i] = current_sin;
+        f32 new_sin = current_sin * cosb + current_cos * sinb;
+        f32 new_cos = current_cos * cosb - current_sin * sinb;
+        current_sin = new_sin;
+        current_cos = new_cos;
+    }
+#endif
+}
+
+// Turns edge vectors into unit normals, rotated 90 degrees. Zero length edges
+// get a zero normal. Arrays must fit 'count' rounded up to a multiple of 4.
+static void edge_normals(f32* x, f32* y, u32 count) {
+#if defined(RUNE_SIMD_SSE2)
+    __m128 zero = _mm_setzero_ps();
+    for (u32 i = 0; i < count; i += 4) {
+        __m128 dx = _mm_loadu_ps(&x[i]);
+        __m128 dy = _mm_loadu_ps(&y[i]);
+        __m128 len2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        __m128 non_zero = _mm_cmpgt_ps(len2, zero);
+        __m128 inv_len = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(len2));
+        inv_len = _mm_and_ps(inv_len, non_zero);
+        _mm_storeu_ps(&x[i], _mm_sub_ps(zero, _mm_mul_ps(dy, inv_len)));
+        _mm_storeu_ps(&y[i], _mm_mul_ps(dx, inv_len));
+    }
+#elif defined(RUNE_SIMD_NEON)
+    float32x4_t zero = vdupq_n_f32(0.0f);
+    for (u32 i = 0; i < count; i += 4) {
+        float32x4_t dx = vld1q_f32(&x[i]);
+        float32x4_t dy = vld1q_f32(&y[i]);
+        float32x4_t len2 = vmlaq_f32(vmulq_f32(dx, dx), dy, dy);
+        uint32x4_t non_zero = vcgtq_f32(len2, zero);
+        float32x4_t inv_len = vdivq_f32(vdupq_n_f32(1.0f), vsqrtq_f32(len2));
+        inv_len = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(inv_len), non_zero));
+        vst1q_f32(&x[i], vnegq_f32(vmulq_f32(dy, inv_len)));
+        vst1q_f32(&y[i], vmulq_f32(dx, inv_len));
+    }
+#else
+    for (u32 i = 0; i < count; i++) {
+        f32 len2 = x[i] * x[i] + y[i] * y[i];
+        f32 inv_len = len2 > 0.0f ? 1.0f / sqrtf(len2) : 0.0f;
+        f32 dx = x[i];
+        x[i] = -y[i] * inv_len;
+        y[i] = dx * inv_len;
+    }
+#endif
+}
+
+// Upper bound for adaptive segment counts of a quarter circle.
+#define ARC_MAX_QUARTER_SEGMENTS 64
+
+// Adaptive arc segmentation state, shared by every command in a tessellation.
+typedef struct ArcCache ArcCache;
+struct ArcCache {
+    SP_Arena* arena;
+    f32 max_error;
+    // Unit quarter circles from 0 to PI/2, indexed by segment count. Built
+    // lazily and reused for every rounded corner and circle.
+    SP_Vec2* quarters[ARC_MAX_QUARTER_SEGMENTS + 1];
+};
+
+// Full precision point of a path. Converted to the vertex layout selected
+// for RNE_Vertex when written to the vertex buffer.
+typedef struct PathPoint PathPoint;
+struct PathPoint {
+    SP_Vec2 pos;
+    SP_Vec2 uv;
+    SP_Color color;
+};
+
 typedef struct Path Path;
 struct Path {
-    RNE_Vertex* points;
+    PathPoint* points;
     u32 point_i;
+    // NULL if the segment counts of the draw commands should be used.
+    ArcCache* arc_cache;
 };
 
-static void push_point(Path* path, RNE_Vertex point) {
+static void push_point(Path* path, PathPoint point) {
     path->points[path->point_i] = point;
     path->point_i++;
 }
 
 static void push_line(Path* path, RNE_DrawLine line) {
-    push_point(path, (RNE_Vertex) {
+    push_point(path, (PathPoint) {
             .pos = line.a,
             .color = line.color,
             .uv = sp_v2s(0.0f),
         });
-    push_point(path, (RNE_Vertex) {
+    push_point(path, (PathPoint) {
             .pos = line.b,
             .color = line.color,
             .uv = sp_v2s(1.0f),
         });
 }
 
+// Segments needed for an arc spanning 'angle' radians to stay within
+// 'max_error' pixels of the true curve.
+static u32 arc_segments_for_error(f32 radius, f32 angle, f32 max_error) {
+    if (radius <= max_error) {
+        return 1;
+    }
+    f32 step = 2.0f * acosf(1.0f - max_error / radius);
+    u32 segments = ceilf(fabsf(angle) / step);
+    u32 max_segments = ceilf(fabsf(angle) / (PI / 2.0f)) * ARC_MAX_QUARTER_SEGMENTS;
+    return sp_clamp(segments, 1, max_segments);
+}
+
+static const SP_Vec2* arc_cache_get_quarter(ArcCache* cache, u32 segments) {
+    if (cache->quarters[segments] == NULL) {
+        SP_Vec2* points = sp_arena_push_no_zero(cache->arena, sizeof(SP_Vec2) * (segments + 1));
+        for (u32 i = 0; i <= segments; i++) {
+            f32 angle = (PI / 2.0f) * i / segments;
+            points[i] = sp_v2(cosf(angle), sinf(angle));
+        }
+        cache->quarters[segments] = points;
+    }
+    return cache->quarters[segments];
+}
+
+// Returns true and writes the whole number of quarter turns if 'angle' is a
+// multiple of PI/2.
+static b8 quarter_turns(f32 angle, i32* turns) {
+    f32 quarters = angle / (PI / 2.0f);
+    f32 rounded = roundf(quarters);
+    if (fabsf(quarters - rounded) > 0.0001f) {
+        return false;
+    }
+    *turns = rounded;
+    return true;
+}
+
 static void push_arc(Path* path, RNE_DrawArc arc) {
+    ArcCache* cache = path->arc_cache;
+    if (cache != NULL) {
+        // Rounded corners and circles start and end on quarter turns and can
+        // be built from the cached quarter circles.
+        i32 start_turns;
+        i32 span_turns;
+        if (quarter_turns(arc.start_angle, &start_turns) &&
+                quarter_turns(arc.end_angle - arc.start_angle, &span_turns) &&
+                span_turns > 0) {
+            u32 segments = arc_segments_for_error(arc.radius, PI / 2.0f, cache->max_error);
+            const SP_Vec2* quarter = arc_cache_get_quarter(cache, segments);
+            u32 point_count = span_turns * segments + 1;
+            for (u32 i = 0; i < point_count; i++) {
+                SP_Vec2 p = quarter[i % segments];
+                u32 turn = ((start_turns + (i32) (i / segments)) % 4 + 4) % 4;
+                SP_Vec2 unit;
+                switch (turn) {
+                    case 0: unit = sp_v2(p.x, p.y); break;
+                    case 1: unit = sp_v2(-p.y, p.x); break;
+                    case 2: unit = sp_v2(-p.x, -p.y); break;
+                    default: unit = sp_v2(p.y, -p.x); break;
+                }
+                // Angles grow clockwise on screen, same as below.
+                unit.y = -unit.y;
+                push_point(path, (PathPoint) {
+                        .pos = sp_v2_add(arc.pos, sp_v2_muls(unit, arc.radius)),
+                        .uv = unit,
+                        .color = arc.color,
+                    });
+            }
+            return;
+        }
+
+        arc.segments = arc_segments_for_error(arc.radius, arc.end_angle - arc.start_angle, cache->max_error);
+    }
+
     arc.start_angle = -arc.start_angle;
     arc.end_angle = -arc.end_angle;
 
-    // https://en.wikipedia.org/wiki/List_of_trigonometric_identities#Angle_sum_and_difference_identities
-    // sin(a + b) = sin(a)*cos(b) + cos(a)*sin(b)
-    // cos(a + b) = cos(a)*cos(b) - sin(a)*sin(b)
-    f32 sina = sinf(arc.start_angle);
-    f32 cosa = cosf(arc.start_angle);
-    f32 b = (arc.end_angle - arc.start_angle) / arc.segments;
-    f32 sinb = sinf(b);
-    f32 cosb = cosf(b);
-
-    f32 current_sin = sina;
-    f32 current_cos = cosa;
-
-    for (u32 i = 0; i <= arc.segments; i++) {
-        push_point(path, (RNE_Vertex) {
-                .pos = sp_v2_add(arc.pos, sp_v2_muls(sp_v2(current_cos, current_sin), arc.radius)),
-                .uv = sp_v2(current_cos, current_sin),
-                .color = arc.color,
-            });
-
-        f32 new_sin = current_sin * cosb + current_cos * sinb;
-        f32 new_cos = current_cos * cosb - current_sin * sinb;
-        current_sin = new_sin;
-        current_cos = new_cos;
+    f32 step = (arc.end_angle - arc.start_angle) / arc.segments;
+    f32 cos_buffer[ARC_CHUNK];
+    f32 sin_buffer[ARC_CHUNK];
+
+    u32 point_count = arc.segments + 1;
+    for (u32 chunk = 0; chunk < point_count; chunk += ARC_CHUNK) {
+        u32 count = sp_min(point_count - chunk, ARC_CHUNK);
+        arc_unit_points(arc.start_angle + step * chunk, step, count, cos_buffer, sin_buffer);
+
+        for (u32 i = 0; i < count; i++) {
+            SP_Vec2 unit = sp_v2(cos_buffer[i], sin_buffer[i]);
+            push_point(path, (PathPoint) {
+                    .pos = sp_v2_add(arc.pos, sp_v2_muls(unit, arc.radius)),
+                    .uv = unit,
+                    .color = arc.color,
+                });
+        }
     }
 }
 
@@ -68,15 +274,65 @@ static void push_circle(Path* path, RNE_DrawCircle circle) {
         });
 }
 
-static void push_rect(Path* path, RNE_DrawRect rect) {
-    f32 min_side = sp_min(rect.size.x, rect.size.y) / 2.0f;
-    for (u8 i = 0; i < sp_arrlen(rect.corner_radius.elements); i++) {
-        rect.corner_radius.elements[i] = sp_clamp(rect.corner_radius.elements[i], 0.0f, min_side);
+static SP_Vec4 clamp_corner_radius(SP_Vec4 corner_radius, SP_Vec2 size) {
+    f32 min_side = sp_min(size.x, size.y) / 2.0f;
+    for (u8 i = 0; i < sp_arrlen(corner_radius.elements); i++) {
+        corner_radius.elements[i] = sp_clamp(corner_radius.elements[i], 0.0f, min_side);
+    }
+    return corner_radius;
+}
+
+// Returns false if the command can't be represented as an instance.
+static b8 cmd_to_instance(const RNE_DrawCmd* cmd, RNE_Instance* instance) {
+    if (!cmd->filled && cmd->thickness <= 0.0f) {
+        return false;
     }
+    f32 stroke_width = cmd->filled ? 0.0f : cmd->thickness;
+
+    switch (cmd->type) {
+        case RNE_DRAW_CMD_TYPE_RECT: {
+            RNE_DrawRect rect = cmd->data.rect;
+            *instance = (RNE_Instance) {
+                .pos = rect.pos,
+                .size = rect.size,
+                .corner_radius = clamp_corner_radius(rect.corner_radius, rect.size),
+                .color = rect.color,
+                .stroke_width = stroke_width,
+            };
+            return true;
+        }
+        case RNE_DRAW_CMD_TYPE_CIRCLE: {
+            RNE_DrawCircle circle = cmd->data.circle;
+            *instance = (RNE_Instance) {
+                .pos = sp_v2_sub(circle.pos, sp_v2s(circle.radius)),
+                .size = sp_v2s(circle.radius * 2.0f),
+                .corner_radius = sp_v4s(circle.radius),
+                .color = circle.color,
+                .stroke_width = stroke_width,
+            };
+            return true;
+        }
+        case RNE_DRAW_CMD_TYPE_IMAGE: {
+            RNE_DrawImage image = cmd->data.image;
+            *instance = (RNE_Instance) {
+                .pos = image.pos,
+                .size = image.size,
+                .color = image.color,
+                .uv = {image.uv[0], image.uv[1]},
+            };
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+static void push_rect(Path* path, RNE_DrawRect rect) {
+    rect.corner_radius = clamp_corner_radius(rect.corner_radius, rect.size);
 
     // Top left
     if (rect.corner_radius.x == 0.0f) {
-        push_point(path, (RNE_Vertex) {
+        push_point(path, (PathPoint) {
                 .pos = rect.pos,
                 .color = rect.color,
             });
@@ -93,7 +349,7 @@ static void push_rect(Path* path, RNE_DrawRect rect) {
 
     // Bottom left
     if (rect.corner_radius.z == 0.0f) {
-        push_point(path, (RNE_Vertex) {
+        push_point(path, (PathPoint) {
                 .pos = sp_v2(rect.pos.x, rect.pos.y + rect.size.y),
                 .color = rect.color,
             });
@@ -110,7 +366,7 @@ static void push_rect(Path* path, RNE_DrawRect rect) {
 
     // Bottom right
     if (rect.corner_radius.w == 0.0f) {
-        push_point(path, (RNE_Vertex) {
+        push_point(path, (PathPoint) {
                 .pos = sp_v2(rect.pos.x + rect.size.x, rect.pos.y + rect.size.y),
                 .color = rect.color,
             });
@@ -127,7 +383,7 @@ static void push_rect(Path* path, RNE_DrawRect rect) {
 
     // Top right
     if (rect.corner_radius.y <= 0.0f) {
-        push_point(path, (RNE_Vertex) {
+        push_point(path, (PathPoint) {
                 .pos = sp_v2(rect.pos.x + rect.size.x, rect.pos.y),
                 .color = rect.color,
             });
@@ -143,6 +399,15 @@ static void push_rect(Path* path, RNE_DrawRect rect) {
     }
 }
 
+static void push_polygon(Path* path, RNE_DrawPolygon polygon) {
+    for (u32 i = 0; i < polygon.point_count; i++) {
+        push_point(path, (PathPoint) {
+                .pos = polygon.points[i],
+                .color = polygon.color,
+            });
+    }
+}
+
 static void push_image(Path* path, RNE_DrawImage rect) {
     f32 uv_left   = rect.uv[0].x;
     f32 uv_right  = rect.uv[1].x;
@@ -150,25 +415,25 @@ static void push_image(Path* path, RNE_DrawImage rect) {
     f32 uv_bottom = rect.uv[1].y;
 
     // Top left
-    push_point(path, (RNE_Vertex) {
+    push_point(path, (PathPoint) {
             .pos = sp_v2(rect.pos.x, rect.pos.y),
             .color = rect.color,
             .uv = sp_v2(uv_left, uv_top),
         });
     // Bottom left
-    push_point(path, (RNE_Vertex) {
+    push_point(path, (PathPoint) {
             .pos = sp_v2(rect.pos.x, rect.pos.y + rect.size.y),
             .color = rect.color,
             .uv = sp_v2(uv_left, uv_bottom),
         });
     // Bottom right
-    push_point(path, (RNE_Vertex) {
+    push_point(path, (PathPoint) {
             .pos = sp_v2(rect.pos.x + rect.size.x, rect.pos.y + rect.size.y),
             .color = rect.color,
             .uv = sp_v2(uv_right, uv_bottom),
         });
     // Top right
-    push_point(path, (RNE_Vertex) {
+    push_point(path, (PathPoint) {
             .pos = sp_v2(rect.pos.x + rect.size.x, rect.pos.y),
             .color = rect.color,
             .uv = sp_v2(uv_right, uv_top),
@@ -181,11 +446,14 @@ struct FattenConfig {
     u32 vertex_capacity;
     u32 vertex_end;
 
-    u16* index_buffer;
+    void* index_buffer;
+    RNE_IndexType index_type;
     u32 index_capacity;
     u32 index_end;
 
     u32 texture_index;
+    u32 texture_layer;
+    b8 anti_aliased;
 };
 
 typedef struct FattenResult FattenResult;
@@ -195,6 +463,112 @@ struct FattenResult {
     b8 out_of_memory;
 };
 
+static void write_index(FattenConfig config, u32 i, u32 value) {
+    if (config.index_type == RNE_INDEX_TYPE_U32) {
+        ((u32*) config.index_buffer)[i] = value;
+    } else {
+        ((u16*) config.index_buffer)[i] = value;
+    }
+}
+
+static void write_vertex(FattenConfig config, u32 i, SP_Vec2 pos, SP_Vec2 uv, SP_Color color) {
+    RNE_Vertex* vertex = &config.vertex_buffer[i];
+#ifdef RUNE_COMPACT_VERTEX
+    // Zero the padding too, so equal vertices compare equal byte for byte.
+    memset(vertex, 0, sizeof(RNE_Vertex));
+#endif
+    vertex->pos = pos;
+#ifdef RUNE_COMPACT_VERTEX
+    // Arcs use unit circle coordinates, so UVs span [-1, 1].
+    vertex->uv[0] = floorf(sp_clamp(uv.x, -1.0f, 1.0f) * 32767.0f + 0.5f);
+    vertex->uv[1] = floorf(sp_clamp(uv.y, -1.0f, 1.0f) * 32767.0f + 0.5f);
+    vertex->color[0] = sp_clamp(color.r, 0.0f, 1.0f) * 255.0f + 0.5f;
+    vertex->color[1] = sp_clamp(color.g, 0.0f, 1.0f) * 255.0f + 0.5f;
+    vertex->color[2] = sp_clamp(color.b, 0.0f, 1.0f) * 255.0f + 0.5f;
+    vertex->color[3] = sp_clamp(color.a, 0.0f, 1.0f) * 255.0f + 0.5f;
+#else
+    vertex->uv = uv;
+    vertex->color = color;
+#endif
+    vertex->texture_index = config.texture_index;
+    vertex->texture_layer = config.texture_layer;
+}
+
+// Width of the feathered edge in pixels when anti-aliasing.
+#define AA_SIZE 1.0f
+
+// Averaged normal of two adjacent edges, scaled so that offsetting by it moves
+// both edges a unit distance.
+static SP_Vec2 miter_normal(SP_Vec2 norm1, SP_Vec2 norm2) {
+    // Honestly, I have no clue what's happening here.
+    // It's taken from the Nuklear function
+    // 'nk_draw_list_stroke_poly_line'.
+    SP_Vec2 avg = sp_v2_divs(sp_v2_add(norm1, norm2), 2.0f);
+    if (sp_v2_magnitude_squared(avg) > 0.000001f) {
+        f32 scale = 1.0f / sp_v2_magnitude_squared(avg);
+        scale = sp_min(scale, 100.0f);
+        avg = sp_v2_muls(avg, scale);
+    }
+    return avg;
+}
+
+// Insets the 'point_count' fill vertices at 'start_offset' by half the AA size
+// and surrounds them with a transparent fringe the same distance outside the
+// shape. Writes 'point_count' vertices right after the fill vertices and
+// 'point_count * 6' indices at 'index_i'.
+static void write_fill_fringe(const Path* path, FattenConfig config, u32 start_offset, u32 index_i) {
+    u32 point_count = path->point_i;
+
+    SP_Scratch scratch = sp_scratch_begin(NULL, 0);
+    u32 padded_count = (point_count + 3) & ~3u;
+    f32* normal_x = sp_arena_push(scratch.arena, sizeof(f32) * padded_count);
+    f32* normal_y = sp_arena_push(scratch.arena, sizeof(f32) * padded_count);
+    f32 area = 0.0f;
+    for (u32 i = 0; i < point_count; i++) {
+        SP_Vec2 a = path->points[i].pos;
+        SP_Vec2 b = path->points[(i + 1) % point_count].pos;
+        normal_x[i] = b.x - a.x;
+        normal_y[i] = b.y - a.y;
+        area += a.x * b.y - b.x * a.y;
+    }
+    edge_normals(normal_x, normal_y, point_count);
+
+    // Edge normals point inwards for a positive area.
+    f32 outwards = area > 0.0f ? -AA_SIZE / 2.0f : AA_SIZE / 2.0f;
+
+    for (u32 i = 0; i < point_count; i++) {
+        u32 i_prev = (point_count + i - 1) % point_count;
+        SP_Vec2 norm1 = sp_v2(normal_x[i_prev], normal_y[i_prev]);
+        SP_Vec2 norm2 = sp_v2(normal_x[i], normal_y[i]);
+        SP_Vec2 offset = sp_v2_muls(miter_normal(norm1, norm2), outwards);
+
+        PathPoint point = path->points[i];
+        SP_Color clear = point.color;
+        clear.a = 0.0f;
+        write_vertex(config, start_offset + i, sp_v2_sub(point.pos, offset), point.uv, point.color);
+        write_vertex(config, start_offset + point_count + i, sp_v2_add(point.pos, offset), point.uv, clear);
+    }
+    sp_scratch_end(scratch);
+
+    for (u32 i = 0; i < point_count; i++) {
+        u32 i_next = (i + 1) % point_count;
+        u32 inner0 = start_offset + i;
+        u32 inner1 = start_offset + i_next;
+        u32 outer0 = start_offset + point_count + i;
+        u32 outer1 = start_offset + point_count + i_next;
+
+        write_index(config, index_i + 0, inner0);
+        write_index(config, index_i + 1, inner1);
+        write_index(config, index_i + 2, outer1);
+
+        write_index(config, index_i + 3, outer1);
+        write_index(config, index_i + 4, outer0);
+        write_index(config, index_i + 5, inner0);
+
+        index_i += 6;
+    }
+}
+
 static FattenResult path_fill_convex(const Path* path, FattenConfig config) {
     sp_assert(path != NULL, "Path can't be NULL.");
     sp_assert(config.vertex_buffer != NULL, "Vertex buffer can't be NULL.");
@@ -207,6 +581,10 @@ static FattenResult path_fill_convex(const Path* path, FattenConfig config) {
     // OOM
     u32 needed_vertices = path->point_i;
     u32 needed_indices = (path->point_i - 2) * 3;
+    if (config.anti_aliased) {
+        needed_vertices += path->point_i;
+        needed_indices += path->point_i * 6;
+    }
     sp_assert(needed_vertices <= config.vertex_capacity, "Vertex buffer too small for object!");
     sp_assert(needed_indices <= config.index_capacity, "Index buffer too small for object!");
     if (config.vertex_capacity - config.vertex_end < needed_vertices ||
@@ -219,16 +597,219 @@ static FattenResult path_fill_convex(const Path* path, FattenConfig config) {
     u32 start_offset = config.vertex_end;
     u32 point_count = path->point_i;
     for (u32 i = 0; i < point_count; i++) {
-        config.vertex_buffer[start_offset + i] = path->points[i];
-        config.vertex_buffer[start_offset + i].texture_index = config.texture_index;
+        PathPoint point = path->points[i];
+        write_vertex(config, start_offset + i, point.pos, point.uv, point.color);
     }
 
     u32 index_i = config.index_end;
     for (u32 i = 1; i < point_count - 1; i++) {
-        config.index_buffer[index_i + 0] = start_offset;
-        config.index_buffer[index_i + 1] = start_offset + i;
-        config.index_buffer[index_i + 2] = start_offset + i + 1;
+        write_index(config, index_i + 0, start_offset);
+        write_index(config, index_i + 1, start_offset + i);
+        write_index(config, index_i + 2, start_offset + i + 1);
+        index_i += 3;
+    }
+
+    if (config.anti_aliased) {
+        write_fill_fringe(path, config, start_offset, index_i);
+    }
+
+    return (FattenResult) {
+        .vertex_count = needed_vertices,
+        .index_count = needed_indices,
+    };
+}
+
+static f32 triangle_area2(SP_Vec2 a, SP_Vec2 b, SP_Vec2 c) {
+    return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+// Vertices left while ear clipping, as a circular doubly linked list.
+typedef struct EarClipper EarClipper;
+struct EarClipper {
+    const PathPoint* points;
+    // Winding order decides which side is inside.
+    f32 winding;
+    u32* prev;
+    u32* next;
+    b8* reflex;
+    b8* ear;
+    // Vertices reflex at the start. Convex vertices never turn reflex while
+    // clipping, so no other vertex can lie inside an ear.
+    u32* reflex_list;
+    u32 reflex_count;
+};
+
+static b8 ear_clipper_is_reflex(const EarClipper* clipper, u32 v) {
+    return triangle_area2(clipper->points[clipper->prev[v]].pos,
+            clipper->points[v].pos,
+            clipper->points[clipper->next[v]].pos) * clipper->winding <= 0.0f;
+}
+
+// A vertex is an ear if it's convex and no reflex vertex lies inside the
+// triangle it forms with its neighbours.
+static b8 ear_clipper_is_ear(const EarClipper* clipper, u32 v) {
+    if (clipper->reflex[v]) {
+        return false;
+    }
+
+    u32 p = clipper->prev[v];
+    u32 n = clipper->next[v];
+    SP_Vec2 a = clipper->points[p].pos;
+    SP_Vec2 b = clipper->points[v].pos;
+    SP_Vec2 c = clipper->points[n].pos;
+    for (u32 i = 0; i < clipper->reflex_count; i++) {
+        u32 r = clipper->reflex_list[i];
+        if (!clipper->reflex[r] || r == p || r == n) {
+            continue;
+        }
+        SP_Vec2 point = clipper->points[r].pos;
+        if (triangle_area2(a, b, point) * clipper->winding >= 0.0f &&
+                triangle_area2(b, c, point) * clipper->winding >= 0.0f &&
+                triangle_area2(c, a, point) * clipper->winding >= 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Ear clipping triangulation of a simple polygon. Produces the same amount of
+// vertices and indices as 'path_fill_convex'.
+//
+// Every vertex is classified once up front. Clipping an ear only changes the
+// triangles of its two neighbours, so only those are classified again. With
+// 'r' reflex vertices that's O(n * r) in total.
+//
+// Degenerate or self-intersecting input can run out of ears. A neighbour of
+// the last clipped ear is then clipped anyway, so the index count stays the
+// same but the remaining triangles may overlap or fall outside the polygon.
+static FattenResult path_fill_concave(const Path* path, FattenConfig config) {
+    sp_assert(path != NULL, "Path can't be NULL.");
+    sp_assert(config.vertex_buffer != NULL, "Vertex buffer can't be NULL.");
+    sp_assert(config.index_buffer != NULL, "Index buffer can't be NULL.");
+
+    if (path->point_i < 3) {
+        return (FattenResult) {0};
+    }
+
+    // OOM
+    u32 needed_vertices = path->point_i;
+    u32 needed_indices = (path->point_i - 2) * 3;
+    if (config.anti_aliased) {
+        needed_vertices += path->point_i;
+        needed_indices += path->point_i * 6;
+    }
+    sp_assert(needed_vertices <= config.vertex_capacity, "Vertex buffer too small for object!");
+    sp_assert(needed_indices <= config.index_capacity, "Index buffer too small for object!");
+    if (config.vertex_capacity - config.vertex_end < needed_vertices ||
+        config.index_capacity - config.index_end < needed_indices) {
+        return (FattenResult) {
+            .out_of_memory = true,
+        };
+    }
+
+    u32 start_offset = config.vertex_end;
+    u32 point_count = path->point_i;
+    for (u32 i = 0; i < point_count; i++) {
+        PathPoint point = path->points[i];
+        write_vertex(config, start_offset + i, point.pos, point.uv, point.color);
+    }
+
+    SP_Scratch scratch = sp_scratch_begin(NULL, 0);
+    EarClipper clipper = {
+        .points = path->points,
+        .prev = sp_arena_push_no_zero(scratch.arena, sizeof(u32) * point_count),
+        .next = sp_arena_push_no_zero(scratch.arena, sizeof(u32) * point_count),
+        .reflex = sp_arena_push_no_zero(scratch.arena, sizeof(b8) * point_count),
+        .ear = sp_arena_push_no_zero(scratch.arena, sizeof(b8) * point_count),
+        .reflex_list = sp_arena_push_no_zero(scratch.arena, sizeof(u32) * point_count),
+    };
+    // Ears waiting to be clipped. Every vertex is pushed once up front and
+    // each clip pushes at most its two neighbours. Entries that stopped being
+    // ears are skipped when popped.
+    u32* ears = sp_arena_push_no_zero(scratch.arena, sizeof(u32) * point_count * 3);
+    u32 ear_count = 0;
+
+    f32 area = 0.0f;
+    for (u32 i = 0; i < point_count; i++) {
+        SP_Vec2 a = path->points[i].pos;
+        SP_Vec2 b = path->points[(i + 1) % point_count].pos;
+        area += a.x * b.y - b.x * a.y;
+    }
+    clipper.winding = area < 0.0f ? -1.0f : 1.0f;
+
+    for (u32 i = 0; i < point_count; i++) {
+        clipper.prev[i] = (point_count + i - 1) % point_count;
+        clipper.next[i] = (i + 1) % point_count;
+    }
+    for (u32 i = 0; i < point_count; i++) {
+        clipper.reflex[i] = ear_clipper_is_reflex(&clipper, i);
+        if (clipper.reflex[i]) {
+            clipper.reflex_list[clipper.reflex_count] = i;
+            clipper.reflex_count++;
+        }
+    }
+    // Pushed in reverse so the first vertex is clipped first.
+    for (u32 i = point_count; i > 0; i--) {
+        clipper.ear[i - 1] = ear_clipper_is_ear(&clipper, i - 1);
+        if (clipper.ear[i - 1]) {
+            ears[ear_count] = i - 1;
+            ear_count++;
+        }
+    }
+
+    u32 index_i = config.index_end;
+    u32 remaining = point_count;
+    // Some vertex that hasn't been clipped yet.
+    u32 current = 0;
+    while (remaining > 3) {
+        if (ear_count > 0) {
+            ear_count--;
+            if (!clipper.ear[ears[ear_count]]) {
+                continue;
+            }
+            current = ears[ear_count];
+        }
+
+        u32 p = clipper.prev[current];
+        u32 n = clipper.next[current];
+        write_index(config, index_i + 0, start_offset + p);
+        write_index(config, index_i + 1, start_offset + current);
+        write_index(config, index_i + 2, start_offset + n);
         index_i += 3;
+
+        clipper.next[p] = n;
+        clipper.prev[n] = p;
+        clipper.reflex[current] = false;
+        clipper.ear[current] = false;
+        remaining--;
+
+        // Only the neighbours' triangles changed. They may have turned convex
+        // and become ears, or stopped being ears.
+        u32 neighbours[2] = {n, p};
+        for (u8 i = 0; i < 2; i++) {
+            u32 v = neighbours[i];
+            if (clipper.reflex[v]) {
+                clipper.reflex[v] = ear_clipper_is_reflex(&clipper, v);
+            }
+            clipper.ear[v] = ear_clipper_is_ear(&clipper, v);
+            if (clipper.ear[v]) {
+                ears[ear_count] = v;
+                ear_count++;
+            }
+        }
+
+        current = p;
+    }
+
+    write_index(config, index_i + 0, start_offset + clipper.prev[current]);
+    write_index(config, index_i + 1, start_offset + current);
+    write_index(config, index_i + 2, start_offset + clipper.next[current]);
+    index_i += 3;
+
+    sp_scratch_end(scratch);
+
+    if (config.anti_aliased) {
+        write_fill_fringe(path, config, start_offset, index_i);
     }
 
     return (FattenResult) {
@@ -249,8 +830,11 @@ static FattenResult path_stroke(const Path* path, FattenConfig config, f32 thick
     }
 
     // OOM
-    u32 needed_vertices = path->point_i * 2;
-    u32 needed_indices = closed ? path->point_i * 6 : (path->point_i - 1) * 6;
+    // Anti-aliased strokes get a transparent fringe vertex on each side.
+    u32 vertices_per_point = config.anti_aliased ? 4 : 2;
+    u32 indices_per_edge = config.anti_aliased ? 18 : 6;
+    u32 needed_vertices = path->point_i * vertices_per_point;
+    u32 needed_indices = closed ? path->point_i * indices_per_edge : (path->point_i - 1) * indices_per_edge;
     sp_assert(needed_vertices <= config.vertex_capacity, "Vertex buffer too small for object!");
     sp_assert(needed_indices <= config.index_capacity, "Index buffer too small for object!");
     if (config.vertex_capacity - config.vertex_end < needed_vertices ||
@@ -262,61 +846,58 @@ static FattenResult path_stroke(const Path* path, FattenConfig config, f32 thick
 
     u32 point_count = path->point_i;
     u32 start_offset = config.vertex_end;
+
+    // Normal of every edge, computed once. Edge i goes from point i to i + 1,
+    // the last one closes the path.
+    SP_Scratch scratch = sp_scratch_begin(NULL, 0);
+    u32 padded_count = (point_count + 3) & ~3u;
+    f32* normal_x = sp_arena_push(scratch.arena, sizeof(f32) * padded_count);
+    f32* normal_y = sp_arena_push(scratch.arena, sizeof(f32) * padded_count);
+    for (u32 i = 0; i < point_count; i++) {
+        SP_Vec2 edge = sp_v2_sub(path->points[(i + 1) % point_count].pos, path->points[i].pos);
+        normal_x[i] = edge.x;
+        normal_y[i] = edge.y;
+    }
+    edge_normals(normal_x, normal_y, point_count);
+
     for (u32 i = 0; i < point_count; i++) {
         SP_Vec2 offset;
         SP_Vec2 curr = path->points[i].pos;
 
         if (!closed && (i == 0 || i + 1 == point_count)) {
-            SP_Vec2 normal;
-            if (i == 0) {
-                SP_Vec2 next = path->points[i + 1].pos;
-                normal = sp_v2_sub(next, curr);
-            } else {
-                SP_Vec2 prev = path->points[i - 1].pos;
-                normal = sp_v2_sub(curr, prev);
-            }
-            normal = sp_v2_normalized(normal);
-            normal = sp_v2(-normal.y, normal.x);
-
+            u32 edge = i == 0 ? 0 : i - 1;
+            SP_Vec2 normal = sp_v2(normal_x[edge], normal_y[edge]);
             offset = sp_v2_muls(normal, thickness / 2.0f);
         } else {
             u32 i_prev = (point_count + i - 1) % point_count;
-            u32 i_next = (i + 1) % point_count;
-
-            SP_Vec2 prev = path->points[i_prev].pos;
-            SP_Vec2 next = path->points[i_next].pos;
-
-            // Calculate edge normals
-            SP_Vec2 norm1 = sp_v2_sub(curr, prev);
-            SP_Vec2 norm2 = sp_v2_sub(next, curr);
-            norm1 = sp_v2_normalized(norm1);
-            norm2 = sp_v2_normalized(norm2);
-            // Rotate 90-degrees to get normal
-            norm1 = sp_v2(-norm1.y, norm1.x);
-            norm2 = sp_v2(-norm2.y, norm2.x);
-
-            // Honestly, I have no clue what's happening here.
-            // It's taken from the Nuklear function
-            // 'nk_draw_list_stroke_poly_line'.
-            SP_Vec2 avg = sp_v2_divs(sp_v2_add(norm1, norm2), 2.0f);
-            if (sp_v2_magnitude_squared(avg) > 0.000001f) {
-                f32 scale = 1.0f / sp_v2_magnitude_squared(avg);
-                scale = sp_min(scale, 100.0f);
-                scale *= thickness / 2.0f;
-                avg = sp_v2_muls(avg, scale);
-            }
-            offset = avg;
+            SP_Vec2 norm1 = sp_v2(normal_x[i_prev], normal_y[i_prev]);
+            SP_Vec2 norm2 = sp_v2(normal_x[i], normal_y[i]);
+            offset = sp_v2_muls(miter_normal(norm1, norm2), thickness / 2.0f);
         }
 
-        config.vertex_buffer[start_offset + i * 2 + 0] = (RNE_Vertex) {
-            .pos = curr,
-            .color = path->points[i].color,
-        };
-        config.vertex_buffer[start_offset + i * 2 + 1] = (RNE_Vertex) {
-            .pos = sp_v2_sub(curr, sp_v2_muls(offset, 2.0f)),
-            .color = path->points[i].color,
-        };
+        SP_Color color = path->points[i].color;
+        u32 out = start_offset + i * vertices_per_point;
+        if (!config.anti_aliased) {
+            write_vertex(config, out + 0, curr, sp_v2s(0.0f), color);
+            write_vertex(config, out + 1, sp_v2_sub(curr, sp_v2_muls(offset, 2.0f)), sp_v2s(0.0f), color);
+            continue;
+        }
+
+        // Solid core shrunk by half the AA size on both sides, with the
+        // fringe reaching half the AA size past the true edges.
+        SP_Vec2 miter = thickness > 0.0f ? sp_v2_divs(offset, thickness / 2.0f) : sp_v2s(0.0f);
+        SP_Vec2 middle = sp_v2_sub(curr, offset);
+        f32 half_inner = sp_max(thickness - AA_SIZE, 0.0f) / 2.0f;
+        f32 half_outer = (thickness + AA_SIZE) / 2.0f;
+        SP_Color clear = color;
+        clear.a = 0.0f;
+
+        write_vertex(config, out + 0, sp_v2_add(middle, sp_v2_muls(miter, half_outer)), sp_v2s(0.0f), clear);
+        write_vertex(config, out + 1, sp_v2_add(middle, sp_v2_muls(miter, half_inner)), sp_v2s(0.0f), color);
+        write_vertex(config, out + 2, sp_v2_sub(middle, sp_v2_muls(miter, half_inner)), sp_v2s(0.0f), color);
+        write_vertex(config, out + 3, sp_v2_sub(middle, sp_v2_muls(miter, half_outer)), sp_v2s(0.0f), clear);
     }
+    sp_scratch_end(scratch);
 
     u32 edge_count = point_count;
     if (!closed) {
@@ -327,20 +908,23 @@ static FattenResult path_stroke(const Path* path, FattenConfig config, f32 thick
     for (u32 i = 0; i < edge_count; i++) {
         u32 i_next = (i + 1) % point_count;
 
-        u32 v0 = start_offset + i * 2;
-        u32 v1 = start_offset + i * 2 + 1;
-        u32 v2 = start_offset + i_next * 2;
-        u32 v3 = start_offset + i_next * 2 + 1;
+        // One quad per band between consecutive vertices of a point.
+        for (u32 band = 0; band + 1 < vertices_per_point; band++) {
+            u32 v0 = start_offset + i * vertices_per_point + band;
+            u32 v1 = v0 + 1;
+            u32 v2 = start_offset + i_next * vertices_per_point + band;
+            u32 v3 = v2 + 1;
 
-        config.index_buffer[index_i + 0] = v0;
-        config.index_buffer[index_i + 1] = v1;
-        config.index_buffer[index_i + 2] = v2;
+            write_index(config, index_i + 0, v0);
+            write_index(config, index_i + 1, v1);
+            write_index(config, index_i + 2, v2);
 
-        config.index_buffer[index_i + 3] = v2;
-        config.index_buffer[index_i + 4] = v3;
-        config.index_buffer[index_i + 5] = v1;
+            write_index(config, index_i + 3, v2);
+            write_index(config, index_i + 4, v3);
+            write_index(config, index_i + 5, v1);
 
-        index_i += 6;
+            index_i += 6;
+        }
     }
 
     return (FattenResult) {
@@ -352,7 +936,9 @@ static FattenResult path_stroke(const Path* path, FattenConfig config, f32 thick
 // Resets path after use.
 static FattenResult path_fatten(Path* path, FattenConfig config, const RNE_DrawCmd* cmd) {
     FattenResult result = {0};
-    if (cmd->filled) {
+    if (cmd->filled && cmd->type == RNE_DRAW_CMD_TYPE_POLYGON) {
+        result = path_fill_concave(path, config);
+    } else if (cmd->filled) {
         result = path_fill_convex(path, config);
     } else {
         result = path_stroke(path, config, cmd->thickness, cmd->closed);
@@ -361,221 +947,1533 @@ static FattenResult path_fatten(Path* path, FattenConfig config, const RNE_DrawC
     return result;
 }
 
-static void push_render_cmd(SP_Arena* arena,
-        RNE_RenderCmd** first,
-        RNE_RenderCmd** last,
-        u32 index_end,
-        u32* index_count,
-        RNE_DrawScissor scissor) {
-    if (*index_count <= 0) {
-        return;
+// Render commands of the batch being built, alongside the geometry which isn't
+// covered by a render command yet. Only one kind of geometry is pending at a
+// time.
+typedef struct RenderCmdList RenderCmdList;
+struct RenderCmdList {
+    SP_Arena* arena;
+    RNE_RenderCmd* first;
+    RNE_RenderCmd* last;
+
+    u32 index_size;
+    u32 index_end;
+    u32 index_count;
+    // Where the batch starts within the index ring.
+    u32 index_offset_bytes;
+
+    u32 instance_end;
+    u32 instance_count;
+};
+
+// Returns where the next 'size' bytes of the ring can be written, wrapping
+// around if they don't fit before the end.
+static void* ring_reserve(RNE_RingBuffer* ring, u32 size) {
+    sp_assert(size <= ring->capacity, "Batch doesn't fit in ring buffer.");
+    if (ring->capacity - ring->offset < size) {
+        ring->wrap(ring);
+        ring->offset = 0;
+    }
+    return (u8*) ring->data + ring->offset;
+}
+
+static void push_render_cmd(RenderCmdList* list, RNE_DrawScissor scissor) {
+    if (list->index_count > 0) {
+        RNE_RenderCmd* render_cmd = sp_arena_push_no_zero(list->arena, sizeof(RNE_RenderCmd));
+        *render_cmd = (RNE_RenderCmd) {
+            .type = RNE_RENDER_CMD_TYPE_TRIANGLES,
+            .start_offset_bytes = list->index_offset_bytes + (list->index_end - list->index_count) * list->index_size,
+            .index_count = list->index_count,
+            .scissor = scissor,
+        };
+        sp_sll_queue_push(list->first, list->last, render_cmd);
+        list->index_count = 0;
+    }
+
+    if (list->instance_count > 0) {
+        RNE_RenderCmd* render_cmd = sp_arena_push_no_zero(list->arena, sizeof(RNE_RenderCmd));
+        *render_cmd = (RNE_RenderCmd) {
+            .type = RNE_RENDER_CMD_TYPE_INSTANCES,
+            .first_instance = list->instance_end - list->instance_count,
+            .instance_count = list->instance_count,
+            .scissor = scissor,
+        };
+        sp_sll_queue_push(list->first, list->last, render_cmd);
+        list->instance_count = 0;
+    }
+}
+
+f32 rne_instance_coverage(RNE_Instance instance, SP_Vec2 point) {
+    SP_Vec2 half_size = sp_v2_divs(instance.size, 2.0f);
+    SP_Vec2 p = sp_v2_sub(point, sp_v2_add(instance.pos, half_size));
+
+    f32 radius;
+    if (p.x < 0.0f) {
+        radius = p.y < 0.0f ? instance.corner_radius.x : instance.corner_radius.z;
+    } else {
+        radius = p.y < 0.0f ? instance.corner_radius.y : instance.corner_radius.w;
     }
 
-    RNE_RenderCmd* render_cmd = sp_arena_push_no_zero(arena, sizeof(RNE_RenderCmd));
-    *render_cmd = (RNE_RenderCmd) {
-        .start_offset_bytes = (index_end - *index_count) * sizeof(u16),
-        .index_count = *index_count,
-        .scissor = scissor,
+    // Signed distance to the rounded rectangle. Negative inside.
+    SP_Vec2 q = sp_v2(fabsf(p.x) - half_size.x + radius, fabsf(p.y) - half_size.y + radius);
+    SP_Vec2 outside = sp_v2(sp_max(q.x, 0.0f), sp_max(q.y, 0.0f));
+    f32 dist = sqrtf(sp_v2_magnitude_squared(outside)) + sp_min(sp_max(q.x, q.y), 0.0f) - radius;
+
+    if (instance.stroke_width > 0.0f) {
+        dist = sp_max(dist, -dist - instance.stroke_width);
+    }
+
+    // One pixel wide anti-aliased edge.
+    return sp_clamp(0.5f - dist, 0.0f, 1.0f);
+}
+
+SP_Vec2 rne_instance_uv(RNE_Instance instance, SP_Vec2 point) {
+    SP_Vec2 t = sp_v2_div(sp_v2_sub(point, instance.pos), instance.size);
+    SP_Vec2 uv_size = sp_v2_sub(instance.uv[1], instance.uv[0]);
+    return sp_v2_add(instance.uv[0], sp_v2_mul(uv_size, t));
+}
+
+// Maps texture handles to their index in the texture buffer of a batch.
+typedef struct TextureTable TextureTable;
+struct TextureTable {
+    RNE_Handle* buffer;
+    u32 capacity;
+    u32 count;
+    // RNE_Handle.ptr -> u32
+    SP_HashMap* map;
+};
+
+static TextureTable texture_table_init(SP_Arena* arena, RNE_Handle* buffer, u32 capacity) {
+    return (TextureTable) {
+        .buffer = buffer,
+        .capacity = capacity,
+        .map = sp_hash_map_create(sp_hash_map_desc_generic(sp_arena_allocator(arena), sp_max(capacity, 1), SP_HASH_COLLISION_RESOLUTION_SEPARATE_CHAINING, void*, u32)),
     };
-    sp_sll_queue_push(*first, *last, render_cmd);
-    *index_count = 0;
 }
 
-// Returns index of wanted texture within buffer.
+// Returns index of wanted texture within the buffer, adding it if needed.
 // If buffer is out of space, returns -1.
-static u32 find_texture(RNE_Handle* buffer, u32 capacity, u32* count, RNE_Handle wanted) {
-    for (u32 i = 0; i < *count; i++) {
-        if (buffer[i].ptr == wanted.ptr) {
-            return i;
-        }
+static i32 texture_table_find(TextureTable* table, RNE_Handle wanted) {
+    u32* index = sp_hash_map_getp(table->map, &wanted.ptr);
+    if (index != NULL) {
+        return *index;
     }
 
     // Too many textures.
-    if (*count == capacity) {
+    if (table->count == table->capacity) {
         return -1;
     }
 
     // Texture not in buffer
-    buffer[*count] = wanted;
-    (*count)++;
-    return *count - 1;
+    u32 new_index = table->count;
+    table->buffer[new_index] = wanted;
+    table->count++;
+    sp_hash_map_insert(table->map, &wanted.ptr, &new_index);
+    return new_index;
 }
 
-static void pre_process_buffer(RNE_DrawCmdBuffer* buffer, RNE_FontInterface font) {
-    for (RNE_DrawCmd* cmd = buffer->first; cmd != NULL; cmd = cmd->next) {
-        if (cmd->type != RNE_DRAW_CMD_TYPE_TEXT) {
-            continue;
-        }
-
-        RNE_DrawText text = cmd->data.text;
-        RNE_Handle atlas = font.get_atlas(text.font_handle, text.font_size);
+static b8 scissor_equal(RNE_DrawScissor a, RNE_DrawScissor b) {
+    return a.pos.x == b.pos.x && a.pos.y == b.pos.y &&
+        a.size.x == b.size.x && a.size.y == b.size.y;
+}
 
-        SP_Vec2 gpos = text.pos;
-        gpos.y += font.get_metrics(text.font_handle, text.font_size).ascent;
-        for (u32 i = 0; i < text.text.len; i++) {
-            RNE_Glyph glyph = font.get_glyph(text.font_handle, text.text.data[i], text.font_size);
-            SP_Vec2 non_snapped = sp_v2_add(gpos, glyph.offset);
-            SP_Vec2 snapped = sp_v2(floorf(non_snapped.x), floorf(non_snapped.y));
+static b8 is_identity_transform(RNE_TessellationConfig config) {
+    return config.scale == 1.0f && config.offset.x == 0.0f && config.offset.y == 0.0f;
+}
 
-            RNE_DrawCmd* image_cmd = sp_arena_push_no_zero(buffer->arena, sizeof(RNE_DrawCmd));
-            *image_cmd = (RNE_DrawCmd) {
-                .type = RNE_DRAW_CMD_TYPE_IMAGE,
-                    .filled = true,
-                    .data.image = {
-                        .pos = snapped,
-                        .size = glyph.size,
-                        .uv = {glyph.uv[0], glyph.uv[1]},
-                        .texture_handle = atlas,
-                        .color = text.color,
-                    },
-            };
-            sp_dll_insert(buffer->first, buffer->last, image_cmd, cmd);
+static SP_Vec2 transform_point(SP_Vec2 point, RNE_TessellationConfig config) {
+    return sp_v2_add(sp_v2_muls(point, config.scale), config.offset);
+}
 
-            gpos.x += glyph.advance;
-            if (font.get_kerning != NULL && i < text.text.len - 1) {
-                gpos.x += font.get_kerning(text.font_handle, text.text.data[i], text.text.data[i+1], text.font_size);
+// Copy of a command moved into the space of the tessellation pass. Polygon
+// points are written to 'points', which holds 'point_capacity' entries. A
+// polygon with more points than that comes back empty.
+static RNE_DrawCmd transform_cmd(const RNE_DrawCmd* cmd,
+        RNE_TessellationConfig config,
+        SP_Vec2* points,
+        u32 point_capacity) {
+    f32 scale = config.scale;
+    RNE_DrawCmd result = *cmd;
+    result.thickness *= scale;
+    switch (cmd->type) {
+        case RNE_DRAW_CMD_TYPE_LINE:
+            result.data.line.a = transform_point(cmd->data.line.a, config);
+            result.data.line.b = transform_point(cmd->data.line.b, config);
+            result.data.line.thickness *= scale;
+            break;
+        case RNE_DRAW_CMD_TYPE_ARC:
+            result.data.arc.pos = transform_point(cmd->data.arc.pos, config);
+            result.data.arc.radius *= scale;
+            break;
+        case RNE_DRAW_CMD_TYPE_CIRCLE:
+            result.data.circle.pos = transform_point(cmd->data.circle.pos, config);
+            result.data.circle.radius *= scale;
+            break;
+        case RNE_DRAW_CMD_TYPE_RECT: {
+            RNE_DrawRect* rect = &result.data.rect;
+            rect->pos = transform_point(rect->pos, config);
+            rect->size = sp_v2_muls(rect->size, scale);
+            rect->corner_radius.x *= scale;
+            rect->corner_radius.y *= scale;
+            rect->corner_radius.z *= scale;
+            rect->corner_radius.w *= scale;
+        } break;
+        case RNE_DRAW_CMD_TYPE_POLYGON:
+            if (cmd->data.polygon.point_count > point_capacity) {
+                result.data.polygon.point_count = 0;
+                break;
             }
-        }
+            for (u32 i = 0; i < cmd->data.polygon.point_count; i++) {
+                points[i] = transform_point(cmd->data.polygon.points[i], config);
+            }
+            result.data.polygon.points = points;
+            break;
+        case RNE_DRAW_CMD_TYPE_TEXT:
+            result.data.text.pos = transform_point(cmd->data.text.pos, config);
+            result.data.text.font_size *= scale;
+            break;
+        case RNE_DRAW_CMD_TYPE_IMAGE:
+            result.data.image.pos = transform_point(cmd->data.image.pos, config);
+            result.data.image.size = sp_v2_muls(cmd->data.image.size, scale);
+            break;
+        case RNE_DRAW_CMD_TYPE_SCISSOR:
+            // Stays unbounded, and equal to the scissor every pass starts with.
+            if (scissor_equal(cmd->data.scissor, RNE_SCISSOR_NONE)) {
+                break;
+            }
+            result.data.scissor.pos = transform_point(cmd->data.scissor.pos, config);
+            result.data.scissor.size = sp_v2_muls(cmd->data.scissor.size, scale);
+            break;
     }
+    return result;
 }
 
-struct RNE_TessellationState {
-    b8 finished;
-    b8 not_first_call;
-    RNE_DrawCmd* current_cmd;
-    RNE_DrawScissor current_scissor;
+// Glyphs of a text command laid out in one go.
+typedef struct TextRun TextRun;
+struct TextRun {
+    RNE_Handle atlas;
+    // Pen position of the first glyph, on the baseline.
+    SP_Vec2 origin;
+    u32 glyph_count;
+    // Relative to 'origin', kerning included.
+    SP_Vec2* positions;
+    RNE_Glyph* glyphs;
 };
 
-RNE_BatchCmd rne_tessellate(RNE_DrawCmdBuffer* buffer,
-        RNE_TessellationConfig config,
-        RNE_TessellationState** state) {
-    RNE_TessellationState* _state = *state;
-    // First call
-    if (_state == NULL) {
-        *state = sp_arena_push(config.arena, sizeof(RNE_TessellationState));
-        _state = *state;
-        _state->current_cmd = buffer->first;
-        _state->current_scissor = (RNE_DrawScissor) {
-            .pos = sp_v2s(-(1<<13)),
-            .size = sp_v2s(1<<14),
-        };
-        pre_process_buffer(buffer, config.font);
-    }
+// Storage the runs are laid out into. Only grows, so laying out a run
+// doesn't allocate once the longest string has been seen.
+typedef struct TextRunBuffer TextRunBuffer;
+struct TextRunBuffer {
+    SP_Arena* arena;
+    u32 capacity;
+    SP_Vec2* positions;
+    RNE_Glyph* glyphs;
+};
 
-    if (_state->finished) {
+// Used when the font doesn't provide 'layout_run'.
+static u32 layout_run_per_glyph(RNE_FontInterface font,
+        RNE_Handle sized_font,
+        SP_Str text,
+        SP_Vec2* out_positions,
+        RNE_Glyph* out_glyphs) {
+    u32 count = 0;
+    f32 pen = 0.0f;
+    u32 prev = 0;
+    for (u32 offset = 0; offset < text.len;) {
+        u32 codepoint = rne_utf8_decode(text, &offset);
+        if (count > 0 && font.get_kerning != NULL) {
+            pen += font.get_kerning(sized_font, prev, codepoint);
+        }
+        out_positions[count] = sp_v2(pen, 0.0f);
+        out_glyphs[count] = font.get_glyph(sized_font, codepoint);
+        pen += out_glyphs[count].advance;
+        prev = codepoint;
+        count++;
+    }
+    return count;
+}
+
+// Invalidates runs previously laid out into 'buffer'.
+static TextRun text_run(RNE_FontInterface font, RNE_DrawText text, TextRunBuffer* buffer) {
+    // UTF-8 never has more codepoints than bytes.
+    if (text.text.len > buffer->capacity) {
+        buffer->capacity = sp_max(text.text.len, buffer->capacity * 2);
+        buffer->positions = sp_arena_push_no_zero(buffer->arena, sizeof(SP_Vec2) * buffer->capacity);
+        buffer->glyphs = sp_arena_push_no_zero(buffer->arena, sizeof(RNE_Glyph) * buffer->capacity);
+    }
+
+    RNE_Handle sized_font = font.get_sized(text.font_handle, text.font_size);
+    TextRun run = {
+        .atlas = font.get_atlas(sized_font),
+        .origin = sp_v2(text.pos.x, text.pos.y + font.get_metrics(sized_font).ascent),
+        .positions = buffer->positions,
+        .glyphs = buffer->glyphs,
+    };
+    if (font.layout_run != NULL) {
+        run.glyph_count = font.layout_run(sized_font, text.text, run.positions, run.glyphs);
+    } else {
+        run.glyph_count = layout_run_per_glyph(font, sized_font, text.text, run.positions, run.glyphs);
+    }
+    return run;
+}
+
+// Glyph 'i' of a run as an image command.
+static RNE_DrawImage text_run_glyph(const TextRun* run, RNE_DrawText text, u32 i) {
+    RNE_Glyph glyph = run->glyphs[i];
+    SP_Vec2 pen = sp_v2_add(run->origin, run->positions[i]);
+    SP_Vec2 non_snapped = sp_v2_add(pen, glyph.offset);
+    SP_Vec2 snapped = sp_v2(floorf(non_snapped.x), floorf(non_snapped.y));
+    return (RNE_DrawImage) {
+        .pos = snapped,
+        .size = glyph.size,
+        .uv = {glyph.uv[0], glyph.uv[1]},
+        .texture_handle = glyph.atlas.ptr != NULL ? glyph.atlas : run->atlas,
+        .color = text.color,
+    };
+}
+
+typedef struct Bounds Bounds;
+struct Bounds {
+    SP_Vec2 min;
+    SP_Vec2 max;
+};
+
+static Bounds bounds_from_rect(SP_Vec2 pos, SP_Vec2 size) {
+    return (Bounds) {
+        .min = pos,
+        .max = sp_v2_add(pos, size),
+    };
+}
+
+static Bounds bounds_union(Bounds a, Bounds b) {
+    return (Bounds) {
+        .min = sp_v2(sp_min(a.min.x, b.min.x), sp_min(a.min.y, b.min.y)),
+        .max = sp_v2(sp_max(a.max.x, b.max.x), sp_max(a.max.y, b.max.y)),
+    };
+}
+
+static Bounds bounds_intersect(Bounds a, Bounds b) {
+    return (Bounds) {
+        .min = sp_v2(sp_max(a.min.x, b.min.x), sp_max(a.min.y, b.min.y)),
+        .max = sp_v2(sp_min(a.max.x, b.max.x), sp_min(a.max.y, b.max.y)),
+    };
+}
+
+static b8 bounds_overlap(Bounds a, Bounds b) {
+    return a.min.x < b.max.x && b.min.x < a.max.x &&
+        a.min.y < b.max.y && b.min.y < a.max.y;
+}
+
+// Conservative screen space bounds of a command, before scissoring. Text is
+// measured by 'text_info' instead.
+static Bounds cmd_bounds(const RNE_DrawCmd* cmd) {
+    switch (cmd->type) {
+        case RNE_DRAW_CMD_TYPE_LINE: {
+            RNE_DrawLine line = cmd->data.line;
+            Bounds bounds = {
+                .min = sp_v2(sp_min(line.a.x, line.b.x), sp_min(line.a.y, line.b.y)),
+                .max = sp_v2(sp_max(line.a.x, line.b.x), sp_max(line.a.y, line.b.y)),
+            };
+            bounds.min = sp_v2_sub(bounds.min, sp_v2s(line.thickness));
+            bounds.max = sp_v2_add(bounds.max, sp_v2s(line.thickness));
+            return bounds;
+        }
+        case RNE_DRAW_CMD_TYPE_ARC: {
+            RNE_DrawArc arc = cmd->data.arc;
+            f32 extent = arc.radius + cmd->thickness;
+            return bounds_from_rect(sp_v2_sub(arc.pos, sp_v2s(extent)), sp_v2s(extent * 2.0f));
+        }
+        case RNE_DRAW_CMD_TYPE_CIRCLE: {
+            RNE_DrawCircle circle = cmd->data.circle;
+            f32 extent = circle.radius + cmd->thickness;
+            return bounds_from_rect(sp_v2_sub(circle.pos, sp_v2s(extent)), sp_v2s(extent * 2.0f));
+        }
+        case RNE_DRAW_CMD_TYPE_RECT:
+            return bounds_from_rect(cmd->data.rect.pos, cmd->data.rect.size);
+        case RNE_DRAW_CMD_TYPE_IMAGE:
+            return bounds_from_rect(cmd->data.image.pos, cmd->data.image.size);
+        case RNE_DRAW_CMD_TYPE_POLYGON: {
+            RNE_DrawPolygon polygon = cmd->data.polygon;
+            if (polygon.point_count == 0) {
+                break;
+            }
+            Bounds bounds = bounds_from_rect(polygon.points[0], sp_v2s(0.0f));
+            for (u32 i = 1; i < polygon.point_count; i++) {
+                bounds = bounds_union(bounds, bounds_from_rect(polygon.points[i], sp_v2s(0.0f)));
+            }
+            bounds.min = sp_v2_sub(bounds.min, sp_v2s(cmd->thickness));
+            bounds.max = sp_v2_add(bounds.max, sp_v2s(cmd->thickness));
+            return bounds;
+        }
+        case RNE_DRAW_CMD_TYPE_TEXT:
+        case RNE_DRAW_CMD_TYPE_SCISSOR:
+            break;
+    }
+    return (Bounds) {0};
+}
+
+// Textures a command will be drawn with, untextured shapes use the null
+// texture just like when tessellating. Text may span several atlas pages, in which case 'switches' counts the
+// changes between consecutive glyphs.
+typedef struct CmdTextures CmdTextures;
+struct CmdTextures {
+    RNE_Handle first;
+    RNE_Handle last;
+    u32 switches;
+};
+
+// Bounds and textures of a text command. Laying out fetches every glyph, so
+// it's done once per command.
+static void text_info(RNE_DrawText text,
+        RNE_FontInterface font,
+        TextRunBuffer* run_buffer,
+        Bounds* out_bounds,
+        CmdTextures* out_textures) {
+    TextRun run = text_run(font, text, run_buffer);
+    Bounds bounds = bounds_from_rect(text.pos, sp_v2s(0.0f));
+    CmdTextures textures = {
+        .first = run.atlas,
+        .last = run.atlas,
+    };
+    for (u32 i = 0; i < run.glyph_count; i++) {
+        RNE_DrawImage glyph = text_run_glyph(&run, text, i);
+        bounds = bounds_union(bounds, bounds_from_rect(glyph.pos, glyph.size));
+        if (i == 0) {
+            textures.first = glyph.texture_handle;
+        } else if (glyph.texture_handle.ptr != textures.last.ptr) {
+            textures.switches++;
+        }
+        textures.last = glyph.texture_handle;
+    }
+    *out_bounds = bounds;
+    *out_textures = textures;
+}
+
+// How many groups back a command may be moved. Bounds the cost of the pass to
+// O(n * REORDER_MAX_LOOKBACK).
+#define REORDER_MAX_LOOKBACK 64
+
+typedef struct ReorderGroup ReorderGroup;
+struct ReorderGroup {
+    RNE_DrawScissor scissor;
+    // Text spanning several atlas pages has switches in here. Such a group
+    // holds a single command and is never merged with.
+    CmdTextures textures;
+    // Union of the scissored bounds of every command in the group.
+    Bounds bounds;
+    RNE_DrawCmd* first;
+    RNE_DrawCmd* last;
+};
+
+// Render commands and texture switches of a sequence of draw states.
+typedef struct StateChanges StateChanges;
+struct StateChanges {
+    b8 started;
+    RNE_DrawScissor scissor;
+    RNE_Handle texture;
+    u32 render_cmds;
+    u32 texture_switches;
+};
+
+static void state_changes_push(StateChanges* changes, RNE_DrawScissor scissor, CmdTextures textures) {
+    if (!changes->started || !scissor_equal(scissor, changes->scissor)) {
+        changes->render_cmds++;
+    }
+    if (changes->started && textures.first.ptr != changes->texture.ptr) {
+        changes->texture_switches++;
+    }
+    changes->texture_switches += textures.switches;
+    changes->started = true;
+    changes->scissor = scissor;
+    changes->texture = textures.last;
+}
+
+RNE_ReorderStats rne_reorder(RNE_DrawCmdBuffer* buffer,
+        RNE_FontInterface font,
+        RNE_Handle null_texture) {
+    RNE_ReorderStats stats = {0};
+
+    u32 cmd_count = 0;
+    for (RNE_DrawCmd* cmd = buffer->first; cmd != NULL; cmd = cmd->next) {
+        if (cmd->type != RNE_DRAW_CMD_TYPE_SCISSOR) {
+            cmd_count++;
+        }
+    }
+    stats.cmd_count = cmd_count;
+
+    SP_Scratch scratch = sp_scratch_begin(&buffer->arena, 1);
+    ReorderGroup* groups = sp_arena_push_no_zero(scratch.arena, sizeof(ReorderGroup) * cmd_count);
+    u32 group_count = 0;
+    TextRunBuffer run_buffer = {.arena = scratch.arena};
+    StateChanges before = {0};
+
+    RNE_DrawScissor scissor = RNE_SCISSOR_NONE;
+    RNE_DrawCmd* next = NULL;
+    for (RNE_DrawCmd* cmd = buffer->first; cmd != NULL; cmd = next) {
+        next = cmd->next;
+        cmd->next = NULL;
+        if (cmd->type == RNE_DRAW_CMD_TYPE_SCISSOR) {
+            scissor = cmd->data.scissor;
+            continue;
+        }
+
+        Bounds bounds;
+        CmdTextures textures = {
+            .first = null_texture,
+            .last = null_texture,
+        };
+        if (cmd->type == RNE_DRAW_CMD_TYPE_TEXT) {
+            text_info(cmd->data.text, font, &run_buffer, &bounds, &textures);
+        } else {
+            bounds = cmd_bounds(cmd);
+            if (cmd->type == RNE_DRAW_CMD_TYPE_IMAGE) {
+                textures.first = cmd->data.image.texture_handle;
+                textures.last = cmd->data.image.texture_handle;
+            }
+        }
+        bounds = bounds_intersect(bounds, bounds_from_rect(scissor.pos, scissor.size));
+        state_changes_push(&before, scissor, textures);
+        b8 mixed = textures.switches != 0;
+
+        // Walk backwards through the groups looking for a matching state. The
+        // command may only be moved past groups it doesn't overlap, otherwise
+        // painter's order would change.
+        ReorderGroup* target = NULL;
+        u32 lookback = sp_min(group_count, REORDER_MAX_LOOKBACK);
+        for (u32 i = 0; i < lookback; i++) {
+            ReorderGroup* group = &groups[group_count - 1 - i];
+            if (!mixed && group->textures.switches == 0 &&
+                    group->textures.first.ptr == textures.first.ptr &&
+                    scissor_equal(group->scissor, scissor)) {
+                target = group;
+                break;
+            }
+            if (bounds_overlap(group->bounds, bounds)) {
+                break;
+            }
+        }
+
+        if (target == NULL) {
+            target = &groups[group_count];
+            group_count++;
+            *target = (ReorderGroup) {
+                .scissor = scissor,
+                .textures = textures,
+                .bounds = bounds,
+            };
+        }
+        target->bounds = bounds_union(target->bounds, bounds);
+        sp_sll_queue_push(target->first, target->last, cmd);
+    }
+    stats.render_cmds_before = before.render_cmds;
+    stats.texture_switches_before = before.texture_switches;
+
+    // Rebuild the command list, only emitting scissor commands where the
+    // scissor actually changes. Every command of a group shares its state, so
+    // the groups alone give the stats after reordering.
+    StateChanges after = {0};
+    buffer->first = NULL;
+    buffer->last = NULL;
+    scissor = RNE_SCISSOR_NONE;
+    for (u32 i = 0; i < group_count; i++) {
+        ReorderGroup* group = &groups[i];
+        state_changes_push(&after, group->scissor, group->textures);
+        if (!scissor_equal(group->scissor, scissor)) {
+            RNE_DrawCmd* scissor_cmd = sp_arena_push(buffer->arena, sizeof(RNE_DrawCmd));
+            scissor_cmd->type = RNE_DRAW_CMD_TYPE_SCISSOR;
+            scissor_cmd->data.scissor = group->scissor;
+            sp_sll_queue_push(buffer->first, buffer->last, scissor_cmd);
+            scissor = group->scissor;
+        }
+
+        if (buffer->last == NULL) {
+            buffer->first = group->first;
+        } else {
+            buffer->last->next = group->first;
+        }
+        buffer->last = group->last;
+    }
+    sp_scratch_end(scratch);
+    stats.render_cmds_after = after.render_cmds;
+    stats.texture_switches_after = after.texture_switches;
+
+    // Keep the backward links valid.
+    RNE_DrawCmd* prev = NULL;
+    for (RNE_DrawCmd* cmd = buffer->first; cmd != NULL; cmd = cmd->next) {
+        cmd->prev = prev;
+        prev = cmd;
+    }
+
+    return stats;
+}
+
+// -- Tessellation cache -------------------------------------------------------
+
+// Blobs are carved out of a single region of at most the byte budget by a
+// buddy allocator. Their sizes are powers of two starting at this size. Freed
+// blobs merge with their buddy, so evicting entries always makes room for a
+// blob of any size eventually.
+#define CACHE_MIN_BLOB_SIZE 64u
+#define CACHE_SIZE_CLASS_COUNT 26
+
+// Stored in the first bytes of a free blob.
+typedef struct CacheFreeBlob CacheFreeBlob;
+struct CacheFreeBlob {
+    CacheFreeBlob* prev;
+    CacheFreeBlob* next;
+};
+
+typedef struct CacheEntry CacheEntry;
+struct CacheEntry {
+    // Bucket chain, or free list when unused.
+    CacheEntry* next;
+    CacheEntry* lru_prev;
+    CacheEntry* lru_next;
+
+    u64 hash;
+    u32 size_class;
+    u32 key_size;
+    u32 vertex_count;
+    u32 index_count;
+    // Key, then vertices, then indices relative to the first vertex.
+    u8* blob;
+};
+
+struct RNE_TessellationCache {
+    SP_Arena* arena;
+    u32 byte_budget;
+
+    CacheEntry** buckets;
+    u32 bucket_count;
+    // Most recently used first.
+    CacheEntry* lru_first;
+    CacheEntry* lru_last;
+
+    CacheEntry* free_entries;
+
+    // Allocated on the first insert.
+    u8* region;
+    u32 region_class;
+    // Size class + 1 of the free blob starting at each CACHE_MIN_BLOB_SIZE
+    // block of the region, 0 if none does.
+    u8* free_classes;
+    CacheFreeBlob* free_blobs[CACHE_SIZE_CLASS_COUNT];
+
+    RNE_TessellationCacheStats stats;
+};
+
+RNE_TessellationCache* rne_tessellation_cache_create(SP_Arena* arena, u32 byte_budget) {
+    RNE_TessellationCache* cache = sp_arena_push(arena, sizeof(RNE_TessellationCache));
+    cache->arena = arena;
+    cache->byte_budget = byte_budget;
+    cache->bucket_count = 64;
+    while (cache->bucket_count < byte_budget / 512) {
+        cache->bucket_count *= 2;
+    }
+    cache->buckets = sp_arena_push(arena, sizeof(CacheEntry*) * cache->bucket_count);
+    while (cache->region_class + 1 < CACHE_SIZE_CLASS_COUNT &&
+            ((u64) CACHE_MIN_BLOB_SIZE << (cache->region_class + 1)) <= byte_budget) {
+        cache->region_class++;
+    }
+    return cache;
+}
+
+RNE_TessellationCacheStats rne_tessellation_cache_stats(const RNE_TessellationCache* cache) {
+    return cache->stats;
+}
+
+// Largest key 'cache_key' can produce for a draw command.
+static u32 cache_key_capacity(u32 max_points) {
+    return sizeof(u32) * 6 + sizeof(((RNE_DrawCmd*) NULL)->data) + sizeof(SP_Vec2) * max_points;
+}
+
+static u8* cache_key_write(u8* out, const void* data, u32 size) {
+    memcpy(out, data, size);
+    return out + size;
+}
+
+// Textured quads keep hard edges. The fringe would inset them without
+// adjusting their UVs, squeezing the texture and smearing its edge texels.
+static b8 cmd_anti_aliased(const RNE_DrawCmd* cmd, RNE_TessellationConfig config) {
+    return config.anti_aliasing && cmd->type != RNE_DRAW_CMD_TYPE_IMAGE;
+}
+
+// Serializes everything the geometry of a command depends on into 'out', which
+// holds 'capacity' bytes. Returns the size of the key, or 0 if the command
+// isn't worth caching or its key doesn't fit.
+static u32 cache_key(const RNE_DrawCmd* cmd, RNE_TessellationConfig config, u8* out, u32 capacity) {
+    u32 header[6] = {
+        cmd->type,
+        cmd->filled,
+        cmd->closed,
+        cmd_anti_aliased(cmd, config),
+    };
+    memcpy(&header[4], &cmd->thickness, sizeof(f32));
+    memcpy(&header[5], &config.arc_max_error, sizeof(f32));
+
+    u8* end = cache_key_write(out, header, sizeof(header));
+    switch (cmd->type) {
+        case RNE_DRAW_CMD_TYPE_LINE:
+            end = cache_key_write(end, &cmd->data.line, sizeof(RNE_DrawLine));
+            break;
+        case RNE_DRAW_CMD_TYPE_ARC:
+            end = cache_key_write(end, &cmd->data.arc, sizeof(RNE_DrawArc));
+            break;
+        case RNE_DRAW_CMD_TYPE_CIRCLE:
+            end = cache_key_write(end, &cmd->data.circle, sizeof(RNE_DrawCircle));
+            break;
+        case RNE_DRAW_CMD_TYPE_RECT:
+            end = cache_key_write(end, &cmd->data.rect, sizeof(RNE_DrawRect));
+            break;
+        case RNE_DRAW_CMD_TYPE_POLYGON: {
+            RNE_DrawPolygon polygon = cmd->data.polygon;
+            u64 size = (end - out) + sizeof(u32) + sizeof(SP_Color) + sizeof(SP_Vec2) * (u64) polygon.point_count;
+            if (size > capacity) {
+                return 0;
+            }
+            end = cache_key_write(end, &polygon.point_count, sizeof(u32));
+            end = cache_key_write(end, &polygon.color, sizeof(SP_Color));
+            end = cache_key_write(end, polygon.points, sizeof(SP_Vec2) * polygon.point_count);
+        } break;
+        // Images and glyphs are a single quad, cheaper to build than to look
+        // up.
+        case RNE_DRAW_CMD_TYPE_IMAGE:
+        case RNE_DRAW_CMD_TYPE_TEXT:
+        case RNE_DRAW_CMD_TYPE_SCISSOR:
+            return 0;
+    }
+    return end - out;
+}
+
+static u32 cache_blob_vertex_offset(u32 key_size) {
+    return (key_size + 7) & ~7u;
+}
+
+static RNE_Vertex* cache_entry_vertices(const CacheEntry* entry) {
+    return (RNE_Vertex*) (entry->blob + cache_blob_vertex_offset(entry->key_size));
+}
+
+static u32* cache_entry_indices(const CacheEntry* entry) {
+    return (u32*) (cache_entry_vertices(entry) + entry->vertex_count);
+}
+
+static void cache_lru_unlink(RNE_TessellationCache* cache, CacheEntry* entry) {
+    if (entry->lru_prev != NULL) {
+        entry->lru_prev->lru_next = entry->lru_next;
+    } else {
+        cache->lru_first = entry->lru_next;
+    }
+    if (entry->lru_next != NULL) {
+        entry->lru_next->lru_prev = entry->lru_prev;
+    } else {
+        cache->lru_last = entry->lru_prev;
+    }
+}
+
+static void cache_lru_push_front(RNE_TessellationCache* cache, CacheEntry* entry) {
+    entry->lru_prev = NULL;
+    entry->lru_next = cache->lru_first;
+    if (cache->lru_first != NULL) {
+        cache->lru_first->lru_prev = entry;
+    } else {
+        cache->lru_last = entry;
+    }
+    cache->lru_first = entry;
+}
+
+static CacheEntry* cache_lookup(RNE_TessellationCache* cache, const u8* key, u32 key_size, u64 hash) {
+    for (CacheEntry* entry = cache->buckets[hash & (cache->bucket_count - 1)];
+            entry != NULL;
+            entry = entry->next) {
+        if (entry->hash == hash &&
+                entry->key_size == key_size &&
+                memcmp(entry->blob, key, key_size) == 0) {
+            cache_lru_unlink(cache, entry);
+            cache_lru_push_front(cache, entry);
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static void cache_blob_link(RNE_TessellationCache* cache, u8* blob, u32 size_class) {
+    CacheFreeBlob* free_blob = (CacheFreeBlob*) blob;
+    free_blob->prev = NULL;
+    free_blob->next = cache->free_blobs[size_class];
+    if (free_blob->next != NULL) {
+        free_blob->next->prev = free_blob;
+    }
+    cache->free_blobs[size_class] = free_blob;
+    cache->free_classes[(blob - cache->region) / CACHE_MIN_BLOB_SIZE] = size_class + 1;
+}
+
+static void cache_blob_unlink(RNE_TessellationCache* cache, u8* blob, u32 size_class) {
+    CacheFreeBlob* free_blob = (CacheFreeBlob*) blob;
+    if (free_blob->prev != NULL) {
+        free_blob->prev->next = free_blob->next;
+    } else {
+        cache->free_blobs[size_class] = free_blob->next;
+    }
+    if (free_blob->next != NULL) {
+        free_blob->next->prev = free_blob->prev;
+    }
+    cache->free_classes[(blob - cache->region) / CACHE_MIN_BLOB_SIZE] = 0;
+}
+
+// Returns NULL if no free blob is large enough.
+static u8* cache_blob_alloc(RNE_TessellationCache* cache, u32 size_class) {
+    u32 free_class = size_class;
+    while (free_class <= cache->region_class && cache->free_blobs[free_class] == NULL) {
+        free_class++;
+    }
+    if (free_class > cache->region_class) {
+        return NULL;
+    }
+
+    u8* blob = (u8*) cache->free_blobs[free_class];
+    cache_blob_unlink(cache, blob, free_class);
+    // Keep the lower half, free the upper one.
+    while (free_class > size_class) {
+        free_class--;
+        cache_blob_link(cache, blob + (CACHE_MIN_BLOB_SIZE << free_class), free_class);
+    }
+    return blob;
+}
+
+static void cache_blob_free(RNE_TessellationCache* cache, u8* blob, u32 size_class) {
+    u32 offset = blob - cache->region;
+    while (size_class < cache->region_class) {
+        u32 buddy = offset ^ (CACHE_MIN_BLOB_SIZE << size_class);
+        if (cache->free_classes[buddy / CACHE_MIN_BLOB_SIZE] != size_class + 1) {
+            break;
+        }
+        cache_blob_unlink(cache, cache->region + buddy, size_class);
+        offset &= ~(CACHE_MIN_BLOB_SIZE << size_class);
+        size_class++;
+    }
+    cache_blob_link(cache, cache->region + offset, size_class);
+}
+
+static void cache_evict(RNE_TessellationCache* cache, CacheEntry* entry) {
+    CacheEntry** link = &cache->buckets[entry->hash & (cache->bucket_count - 1)];
+    while (*link != entry) {
+        link = &(*link)->next;
+    }
+    *link = entry->next;
+    cache_lru_unlink(cache, entry);
+
+    cache_blob_free(cache, entry->blob, entry->size_class);
+    entry->next = cache->free_entries;
+    cache->free_entries = entry;
+
+    cache->stats.entry_count--;
+    cache->stats.bytes_used -= CACHE_MIN_BLOB_SIZE << entry->size_class;
+    cache->stats.evictions++;
+}
+
+static u32 read_index(FattenConfig config, u32 i) {
+    if (config.index_type == RNE_INDEX_TYPE_U32) {
+        return ((u32*) config.index_buffer)[i];
+    }
+    return ((u16*) config.index_buffer)[i];
+}
+
+// Stores the geometry 'path_fatten' just wrote at the end of the buffers.
+static void cache_insert(RNE_TessellationCache* cache,
+        const u8* key,
+        u32 key_size,
+        u64 hash,
+        FattenConfig config,
+        FattenResult result) {
+    u32 blob_size = cache_blob_vertex_offset(key_size) +
+        sizeof(RNE_Vertex) * result.vertex_count +
+        sizeof(u32) * result.index_count;
+    u32 size_class = 0;
+    while (size_class < CACHE_SIZE_CLASS_COUNT && (CACHE_MIN_BLOB_SIZE << size_class) < blob_size) {
+        size_class++;
+    }
+    u32 class_size = CACHE_MIN_BLOB_SIZE << size_class;
+    if (size_class >= CACHE_SIZE_CLASS_COUNT || class_size > cache->byte_budget) {
+        return;
+    }
+
+    if (cache->region == NULL) {
+        u32 region_size = CACHE_MIN_BLOB_SIZE << cache->region_class;
+        cache->region = sp_arena_push_no_zero(cache->arena, region_size);
+        cache->free_classes = sp_arena_push(cache->arena, region_size / CACHE_MIN_BLOB_SIZE);
+        cache_blob_link(cache, cache->region, cache->region_class);
+    }
+
+    u8* blob = cache_blob_alloc(cache, size_class);
+    while (blob == NULL) {
+        cache_evict(cache, cache->lru_last);
+        blob = cache_blob_alloc(cache, size_class);
+    }
+
+    CacheEntry* entry = cache->free_entries;
+    if (entry != NULL) {
+        cache->free_entries = entry->next;
+    } else {
+        entry = sp_arena_push_no_zero(cache->arena, sizeof(CacheEntry));
+    }
+
+    *entry = (CacheEntry) {
+        .hash = hash,
+        .size_class = size_class,
+        .key_size = key_size,
+        .vertex_count = result.vertex_count,
+        .index_count = result.index_count,
+        .blob = blob,
+    };
+    memcpy(blob, key, key_size);
+    memcpy(cache_entry_vertices(entry),
+            &config.vertex_buffer[config.vertex_end],
+            sizeof(RNE_Vertex) * result.vertex_count);
+    u32* indices = cache_entry_indices(entry);
+    for (u32 i = 0; i < result.index_count; i++) {
+        indices[i] = read_index(config, config.index_end + i) - config.vertex_end;
+    }
+
+    CacheEntry** bucket = &cache->buckets[hash & (cache->bucket_count - 1)];
+    entry->next = *bucket;
+    *bucket = entry;
+    cache_lru_push_front(cache, entry);
+
+    cache->stats.entry_count++;
+    cache->stats.bytes_used += class_size;
+}
+
+// Copies cached geometry to the end of the buffers, like 'path_fatten' would
+// have written it.
+static FattenResult cache_emit(const CacheEntry* entry, FattenConfig config) {
+    sp_assert(entry->vertex_count <= config.vertex_capacity, "Vertex buffer too small for object!");
+    sp_assert(entry->index_count <= config.index_capacity, "Index buffer too small for object!");
+    if (config.vertex_capacity - config.vertex_end < entry->vertex_count ||
+        config.index_capacity - config.index_end < entry->index_count) {
+        return (FattenResult) {
+            .out_of_memory = true,
+        };
+    }
+
+    RNE_Vertex* vertices = &config.vertex_buffer[config.vertex_end];
+    memcpy(vertices, cache_entry_vertices(entry), sizeof(RNE_Vertex) * entry->vertex_count);
+    for (u32 i = 0; i < entry->vertex_count; i++) {
+        vertices[i].texture_index = config.texture_index;
+        vertices[i].texture_layer = config.texture_layer;
+    }
+
+    const u32* indices = cache_entry_indices(entry);
+    for (u32 i = 0; i < entry->index_count; i++) {
+        write_index(config, config.index_end + i, config.vertex_end + indices[i]);
+    }
+
+    return (FattenResult) {
+        .vertex_count = entry->vertex_count,
+        .index_count = entry->index_count,
+    };
+}
+
+struct RNE_TessellationState {
+    b8 finished;
+    b8 not_first_call;
+    RNE_DrawCmd* current_cmd;
+    // Command to stop at, NULL for the whole buffer.
+    RNE_DrawCmd* end_cmd;
+    RNE_DrawScissor current_scissor;
+    ArcCache arc_cache;
+
+    // Progress through the current text command. The whole string is laid
+    // out when the command is reached, then emitted one glyph at a time so it
+    // can be resumed in the next batch.
+    const RNE_DrawCmd* text_cmd;
+    TextRun text_run;
+    TextRunBuffer text_run_buffer;
+    u32 glyph_i;
+
+    // Used to stitch parallel jobs back together, see 'rne_tessellate_merge'.
+    b8 geometry_emitted;
+    b8 leading_scissor_change;
+    b8 trailing_scissor_change;
+};
+
+// Moves on to the next glyph of a text command, or to the next command.
+static void state_advance(RNE_TessellationState* state) {
+    RNE_DrawCmd* cmd = state->current_cmd;
+    if (cmd->type == RNE_DRAW_CMD_TYPE_TEXT) {
+        state->glyph_i++;
+        if (state->glyph_i < state->text_run.glyph_count) {
+            return;
+        }
+    }
+    state->glyph_i = 0;
+    state->current_cmd = cmd->next;
+}
+
+// Whether a polygon fits in an empty batch. Checked before any of its points
+// are copied, the path only has room for 'vertex_capacity' points.
+static b8 polygon_fits(const RNE_DrawCmd* cmd, RNE_TessellationConfig config) {
+    u64 point_count = cmd->data.polygon.point_count;
+    if (point_count < 3) {
+        return true;
+    }
+
+    u64 needed_vertices;
+    u64 needed_indices;
+    if (cmd->filled) {
+        needed_vertices = point_count;
+        needed_indices = (point_count - 2) * 3;
+        if (config.anti_aliasing) {
+            needed_vertices += point_count;
+            needed_indices += point_count * 6;
+        }
+    } else {
+        needed_vertices = point_count * (config.anti_aliasing ? 4 : 2);
+        needed_indices = point_count * (config.anti_aliasing ? 18 : 6);
+    }
+    return needed_vertices <= config.vertex_capacity && needed_indices <= config.index_capacity;
+}
+
+static RNE_BatchCmd tessellate_batch(RNE_TessellationConfig config, RNE_TessellationState* _state) {
+    if (config.scale == 0.0f) {
+        config.scale = 1.0f;
+    }
+
+    // Don't reserve ring space for an empty batch.
+    if (_state->current_cmd == _state->end_cmd) {
         return (RNE_BatchCmd) {0};
     }
 
-    RNE_RenderCmd* first = NULL;
-    RNE_RenderCmd* last = NULL;
+    RenderCmdList cmds = {
+        .arena = config.arena,
+        .index_size = config.index_type == RNE_INDEX_TYPE_U32 ? sizeof(u32) : sizeof(u16),
+    };
+
+    // 16-bit indices can't address more vertices than this.
+    if (config.index_type == RNE_INDEX_TYPE_U16) {
+        config.vertex_capacity = sp_min(config.vertex_capacity, 1 << 16);
+    }
+
+    u32 base_vertex = 0;
+    if (config.vertex_ring != NULL) {
+        config.vertex_buffer = ring_reserve(config.vertex_ring, config.vertex_capacity * sizeof(RNE_Vertex));
+        base_vertex = config.vertex_ring->offset / sizeof(RNE_Vertex);
+    }
+    if (config.index_ring != NULL) {
+        config.index_buffer = ring_reserve(config.index_ring, config.index_capacity * cmds.index_size);
+        cmds.index_offset_bytes = config.index_ring->offset;
+    }
 
     u32 vertex_end = 0;
-    u32 index_end = 0;
-    u32 index_count = 0;
-    u32 texture_count = 0;
 
     SP_Scratch scratch = sp_scratch_begin(&config.arena, 1);
-    RNE_Vertex* points = sp_arena_push_no_zero(scratch.arena, sizeof(RNE_Vertex) * config.vertex_capacity);
+    TextureTable textures = {0};
+    if (config.get_texture_slot == NULL) {
+#ifdef RUNE_COMPACT_VERTEX
+        sp_assert(config.texture_capacity <= 0x100, "Texture capacity doesn't fit in a compact vertex.");
+#endif
+        textures = texture_table_init(scratch.arena, config.texture_buffer, config.texture_capacity);
+    }
+    PathPoint* points = sp_arena_push_no_zero(scratch.arena, sizeof(PathPoint) * config.vertex_capacity);
     Path path = {
         .points = points,
     };
+    if (config.arc_max_error > 0.0f) {
+        _state->arc_cache.max_error = config.arc_max_error;
+        path.arc_cache = &_state->arc_cache;
+    }
+    b8 transformed = !is_identity_transform(config);
+    SP_Vec2* transformed_points = NULL;
+    if (transformed) {
+        transformed_points = sp_arena_push_no_zero(scratch.arena, sizeof(SP_Vec2) * config.vertex_capacity);
+    }
+    u8* cache_key_buffer = NULL;
+    u32 cache_key_buffer_size = 0;
+    if (config.cache != NULL) {
+        cache_key_buffer_size = cache_key_capacity(config.vertex_capacity);
+        cache_key_buffer = sp_arena_push_no_zero(scratch.arena, cache_key_buffer_size);
+    }
 
-    for (; _state->current_cmd != NULL; _state->current_cmd = _state->current_cmd->next) {
+    for (; _state->current_cmd != _state->end_cmd; state_advance(_state)) {
         RNE_DrawCmd* cmd = _state->current_cmd;
         RNE_Handle texture = config.null_texture;
-        switch (cmd->type) {
-            case RNE_DRAW_CMD_TYPE_LINE:
-                push_line(&path, cmd->data.line);
-                break;
-            case RNE_DRAW_CMD_TYPE_ARC:
-                push_arc(&path, cmd->data.arc);
-                if (cmd->filled) {
-                    push_point(&path, (RNE_Vertex) {
-                            .pos = cmd->data.arc.pos,
-                            .color = cmd->data.arc.color,
-                        });
-                }
-                break;
-            case RNE_DRAW_CMD_TYPE_CIRCLE:
-                push_circle(&path, cmd->data.circle);
-                break;
-            case RNE_DRAW_CMD_TYPE_RECT:
-                push_rect(&path, cmd->data.rect);
-                break;
-            case RNE_DRAW_CMD_TYPE_IMAGE:
-                push_image(&path, cmd->data.image);
-                texture = cmd->data.image.texture_handle;
-                break;
-            case RNE_DRAW_CMD_TYPE_TEXT:
-                break;
-            case RNE_DRAW_CMD_TYPE_SCISSOR:
-                push_render_cmd(config.arena,
-                        &first,
-                        &last,
-                        index_end,
-                        &index_count,
-                        _state->current_scissor);
-                _state->current_scissor = cmd->data.scissor;
+
+        // A polygon that doesn't fit in any batch is dropped on its own
+        // instead of stalling the rest of the buffer.
+        if (cmd->type == RNE_DRAW_CMD_TYPE_POLYGON && !polygon_fits(cmd, config)) {
+            continue;
+        }
+
+        RNE_DrawCmd transformed_cmd;
+        if (transformed) {
+            transformed_cmd = transform_cmd(cmd, config, transformed_points, config.vertex_capacity);
+            cmd = &transformed_cmd;
+        }
+
+        // Each glyph is drawn like its own image command.
+        RNE_DrawCmd glyph_cmd;
+        if (cmd->type == RNE_DRAW_CMD_TYPE_TEXT) {
+            RNE_DrawText text = cmd->data.text;
+            if (_state->text_cmd != _state->current_cmd) {
+                _state->text_cmd = _state->current_cmd;
+                _state->text_run = text_run(config.font, text, &_state->text_run_buffer);
+            }
+            if (_state->text_run.glyph_count == 0) {
+                continue;
+            }
+            glyph_cmd = (RNE_DrawCmd) {
+                .type = RNE_DRAW_CMD_TYPE_IMAGE,
+                .filled = true,
+                .data.image = text_run_glyph(&_state->text_run, text, _state->glyph_i),
+            };
+            cmd = &glyph_cmd;
+        }
+
+        RNE_Instance instance;
+        b8 instanced = config.instance_buffer != NULL && cmd_to_instance(cmd, &instance);
+
+        // Shapes seen in an earlier frame skip building the path.
+        u32 key_size = 0;
+        u64 key_hash = 0;
+        CacheEntry* cached = NULL;
+        if (config.cache != NULL && !instanced) {
+            key_size = cache_key(cmd, config, cache_key_buffer, cache_key_buffer_size);
+            if (key_size > 0) {
+                key_hash = sp_fvn1a_hash(cache_key_buffer, key_size);
+                cached = cache_lookup(config.cache, cache_key_buffer, key_size, key_hash);
+            }
+        }
+
+        if (cached == NULL) {
+            switch (cmd->type) {
+                case RNE_DRAW_CMD_TYPE_LINE:
+                    push_line(&path, cmd->data.line);
+                    break;
+                case RNE_DRAW_CMD_TYPE_ARC:
+                    push_arc(&path, cmd->data.arc);
+                    if (cmd->filled) {
+                        push_point(&path, (PathPoint) {
+                                .pos = cmd->data.arc.pos,
+                                .color = cmd->data.arc.color,
+                            });
+                    }
+                    break;
+                case RNE_DRAW_CMD_TYPE_CIRCLE:
+                    if (!instanced) {
+                        push_circle(&path, cmd->data.circle);
+                    }
+                    break;
+                case RNE_DRAW_CMD_TYPE_RECT:
+                    if (!instanced) {
+                        push_rect(&path, cmd->data.rect);
+                    }
+                    break;
+                case RNE_DRAW_CMD_TYPE_POLYGON:
+                    push_polygon(&path, cmd->data.polygon);
+                    break;
+                case RNE_DRAW_CMD_TYPE_IMAGE:
+                    if (!instanced) {
+                        push_image(&path, cmd->data.image);
+                    }
+                    texture = cmd->data.image.texture_handle;
+                    break;
+                case RNE_DRAW_CMD_TYPE_TEXT:
+                    break;
+                case RNE_DRAW_CMD_TYPE_SCISSOR:
+                    // Redundant scissors don't split the render command.
+                    if (scissor_equal(cmd->data.scissor, _state->current_scissor)) {
+                        break;
+                    }
+                    push_render_cmd(&cmds, _state->current_scissor);
+                    _state->current_scissor = cmd->data.scissor;
+                    _state->leading_scissor_change |= !_state->geometry_emitted;
+                    _state->trailing_scissor_change = true;
+                    break;
+            }
+        }
+
+        RNE_TextureSlot slot;
+        if (config.get_texture_slot != NULL) {
+            slot = config.get_texture_slot(texture);
+#ifdef RUNE_COMPACT_VERTEX
+            sp_assert(slot.index <= 0xff && slot.layer <= 0xff, "Texture slot doesn't fit in a compact vertex.");
+#endif
+        } else {
+            i32 texture_index = texture_table_find(&textures, texture);
+            if (texture_index < 0) {
+                push_render_cmd(&cmds, _state->current_scissor);
                 break;
+            }
+            slot = (RNE_TextureSlot) {
+                .index = texture_index,
+            };
         }
 
-        i32 texture_index = find_texture(config.texture_buffer,
-                    config.texture_capacity,
-                    &texture_count,
-                    texture);
-        if (texture_index < 0) {
-            push_render_cmd(config.arena,
-                    &first,
-                    &last,
-                    index_end,
-                    &index_count,
-                    _state->current_scissor);
-            break;
+        if (instanced) {
+            if (cmds.instance_end == config.instance_capacity) {
+                push_render_cmd(&cmds, _state->current_scissor);
+                break;
+            }
+
+            // Keep painter's order between triangles and instances.
+            if (cmds.index_count > 0) {
+                push_render_cmd(&cmds, _state->current_scissor);
+            }
+
+            instance.texture_index = slot.index;
+            instance.texture_layer = slot.layer;
+            config.instance_buffer[cmds.instance_end] = instance;
+            cmds.instance_end++;
+            cmds.instance_count++;
+            _state->geometry_emitted = true;
+            _state->trailing_scissor_change = false;
+            continue;
         }
 
-        FattenResult result = path_fatten(&path, (FattenConfig) {
-                .vertex_buffer = config.vertex_buffer,
-                .vertex_capacity = config.vertex_capacity,
-                .vertex_end = vertex_end,
+        FattenConfig fatten_config = {
+            .vertex_buffer = config.vertex_buffer,
+            .vertex_capacity = config.vertex_capacity,
+            .vertex_end = vertex_end,
 
-                .index_buffer = config.index_buffer,
-                .index_capacity = config.index_capacity,
-                .index_end = index_end,
+            .index_buffer = config.index_buffer,
+            .index_type = config.index_type,
+            .index_capacity = config.index_capacity,
+            .index_end = cmds.index_end,
 
-                .texture_index = texture_index,
-            }, cmd);
+            .texture_index = slot.index,
+            .texture_layer = slot.layer,
+            .anti_aliased = cmd_anti_aliased(cmd, config),
+        };
+        FattenResult result;
+        if (cached != NULL) {
+            result = cache_emit(cached, fatten_config);
+            // Counted once emitted, a command retried in the next batch
+            // would count twice otherwise.
+            if (!result.out_of_memory) {
+                config.cache->stats.hits++;
+            }
+        } else {
+            result = path_fatten(&path, fatten_config, cmd);
+            if (key_size > 0 && !result.out_of_memory) {
+                config.cache->stats.misses++;
+                cache_insert(config.cache, cache_key_buffer, key_size, key_hash, fatten_config, result);
+            }
+        }
 
         if (result.out_of_memory) {
-            push_render_cmd(config.arena,
-                    &first,
-                    &last,
-                    index_end,
-                    &index_count,
-                    _state->current_scissor);
+            push_render_cmd(&cmds, _state->current_scissor);
             break;
         }
 
+        if (result.index_count > 0 && cmds.instance_count > 0) {
+            push_render_cmd(&cmds, _state->current_scissor);
+        }
+
         vertex_end += result.vertex_count;
-        index_end += result.index_count;
-        index_count += result.index_count;
+        cmds.index_end += result.index_count;
+        cmds.index_count += result.index_count;
+        if (result.index_count > 0) {
+            _state->geometry_emitted = true;
+            _state->trailing_scissor_change = false;
+        }
     }
     sp_scratch_end(scratch);
 
-    if (_state->current_cmd == NULL && !_state->finished && index_count > 0) {
-        push_render_cmd(config.arena,
-                &first,
-                &last,
-                index_end,
-                &index_count,
-                _state->current_scissor);
+    if (_state->current_cmd == _state->end_cmd && !_state->finished &&
+            (cmds.index_count > 0 || cmds.instance_count > 0)) {
+        push_render_cmd(&cmds, _state->current_scissor);
         _state->finished = true;
     }
 
+    if (config.vertex_ring != NULL) {
+        config.vertex_ring->offset += vertex_end * sizeof(RNE_Vertex);
+    }
+    if (config.index_ring != NULL) {
+        config.index_ring->offset += cmds.index_end * cmds.index_size;
+    }
+
     RNE_BatchCmd batch_cmd = {
+        .base_vertex = base_vertex,
         .vertex_count = vertex_end,
-        .index_count = index_end,
-        .texture_count = texture_count,
-        .render_cmds = first,
+        .index_count = cmds.index_end,
+        .instance_count = cmds.instance_end,
+        .texture_count = textures.count,
+        .render_cmds = cmds.first,
     };
     return batch_cmd;
 }
+
+RNE_BatchCmd rne_tessellate(const RNE_DrawCmdBuffer* buffer,
+        RNE_TessellationConfig config,
+        RNE_TessellationState** state) {
+    RNE_TessellationState* _state = *state;
+    // First call
+    if (_state == NULL) {
+        *state = sp_arena_push(config.arena, sizeof(RNE_TessellationState));
+        _state = *state;
+        _state->current_cmd = buffer->first;
+        _state->current_scissor = RNE_SCISSOR_NONE;
+        _state->arc_cache.arena = config.arena;
+        _state->text_run_buffer.arena = config.arena;
+    }
+
+    if (_state->finished) {
+        return (RNE_BatchCmd) {0};
+    }
+
+    return tessellate_batch(config, _state);
+}
+
+// -- Parallel tessellation ----------------------------------------------------
+
+typedef struct TessellationJob TessellationJob;
+struct TessellationJob {
+    RNE_DrawCmd* first;
+    RNE_DrawCmd* end;
+    RNE_DrawScissor scissor;
+
+    // Written by 'rne_tessellate_job_run'.
+    RNE_TessellationConfig config;
+    RNE_TessellationState state;
+    RNE_BatchCmd batch;
+};
+
+struct RNE_TessellationJobs {
+    RNE_TessellationConfig config;
+    TessellationJob* jobs;
+    u32 job_count;
+};
+
+RNE_TessellationJobs* rne_tessellate_split(const RNE_DrawCmdBuffer* buffer,
+        RNE_TessellationConfig config,
+        u32 max_jobs) {
+    sp_assert(max_jobs > 0, "Need at least one job.");
+
+    if (config.scale == 0.0f) {
+        config.scale = 1.0f;
+    }
+
+    // Request every glyph up front so the jobs only hit the font's caches.
+    SP_Scratch scratch = sp_scratch_begin(&config.arena, 1);
+    TextRunBuffer run_buffer = {.arena = scratch.arena};
+    for (RNE_DrawCmd* cmd = buffer->first; cmd != NULL; cmd = cmd->next) {
+        if (cmd->type == RNE_DRAW_CMD_TYPE_TEXT) {
+            RNE_DrawText text = transform_cmd(cmd, config, NULL, 0).data.text;
+            text_run(config.font, text, &run_buffer);
+        }
+    }
+    sp_scratch_end(scratch);
+
+    u32 cmd_count = 0;
+    for (RNE_DrawCmd* cmd = buffer->first; cmd != NULL; cmd = cmd->next) {
+        cmd_count++;
+    }
+
+    RNE_TessellationJobs* jobs = sp_arena_push(config.arena, sizeof(RNE_TessellationJobs));
+    jobs->config = config;
+    jobs->job_count = sp_max(sp_min(max_jobs, cmd_count), 1);
+    jobs->jobs = sp_arena_push(config.arena, sizeof(TessellationJob) * jobs->job_count);
+
+    // Even split by command count. Each job starts with the scissor that's in
+    // effect at its first command.
+    u32 per_job = (cmd_count + jobs->job_count - 1) / jobs->job_count;
+    RNE_DrawScissor scissor = RNE_SCISSOR_NONE;
+    RNE_DrawCmd* cmd = buffer->first;
+    for (u32 i = 0; i < jobs->job_count; i++) {
+        TessellationJob* job = &jobs->jobs[i];
+        job->first = cmd;
+        job->scissor = scissor;
+        for (u32 j = 0; j < per_job && cmd != NULL; j++) {
+            if (cmd->type == RNE_DRAW_CMD_TYPE_SCISSOR) {
+                scissor = transform_cmd(cmd, config, NULL, 0).data.scissor;
+            }
+            cmd = cmd->next;
+        }
+        job->end = cmd;
+    }
+
+    return jobs;
+}
+
+u32 rne_tessellate_job_count(const RNE_TessellationJobs* jobs) {
+    return jobs->job_count;
+}
+
+void rne_tessellate_job_run(RNE_TessellationJobs* jobs, u32 index, SP_Arena* arena) {
+    sp_assert(index < jobs->job_count, "Job index out of bounds.");
+    TessellationJob* job = &jobs->jobs[index];
+
+    // Private copies of the output buffers, sized like the real ones since
+    // the job can't know how much of them it will use.
+    RNE_TessellationConfig config = jobs->config;
+    config.arena = arena;
+    if (config.index_type == RNE_INDEX_TYPE_U16) {
+        config.vertex_capacity = sp_min(config.vertex_capacity, 1 << 16);
+    }
+    u32 index_size = config.index_type == RNE_INDEX_TYPE_U32 ? sizeof(u32) : sizeof(u16);
+    config.vertex_buffer = sp_arena_push_no_zero(arena, sizeof(RNE_Vertex) * config.vertex_capacity);
+    config.index_buffer = sp_arena_push_no_zero(arena, index_size * config.index_capacity);
+    config.vertex_ring = NULL;
+    config.index_ring = NULL;
+    config.cache = NULL;
+    config.texture_buffer = sp_arena_push_no_zero(arena, sizeof(RNE_Handle) * config.texture_capacity);
+    if (config.instance_buffer != NULL) {
+        config.instance_buffer = sp_arena_push_no_zero(arena, sizeof(RNE_Instance) * config.instance_capacity);
+    }
+
+    job->config = config;
+    job->state = (RNE_TessellationState) {
+        .current_cmd = job->first,
+        .end_cmd = job->end,
+        .current_scissor = job->scissor,
+        .arc_cache.arena = arena,
+        .text_run_buffer.arena = arena,
+    };
+    job->batch = tessellate_batch(config, &job->state);
+}
+
+b8 rne_tessellate_merge(RNE_TessellationJobs* jobs, RNE_BatchCmd* batch) {
+    RNE_TessellationConfig config = jobs->config;
+    if (config.index_type == RNE_INDEX_TYPE_U16) {
+        config.vertex_capacity = sp_min(config.vertex_capacity, 1 << 16);
+    }
+
+    // Everything has to fit in a single batch, like the serial path would
+    // have produced.
+    u32 vertex_count = 0;
+    u32 index_count = 0;
+    u32 instance_count = 0;
+    for (u32 i = 0; i < jobs->job_count; i++) {
+        TessellationJob* job = &jobs->jobs[i];
+        if (job->state.current_cmd != job->end) {
+            return false;
+        }
+        vertex_count += job->batch.vertex_count;
+        index_count += job->batch.index_count;
+        instance_count += job->batch.instance_count;
+    }
+    if (vertex_count > config.vertex_capacity ||
+            index_count > config.index_capacity ||
+            instance_count > config.instance_capacity) {
+        return false;
+    }
+
+    u32 index_size = config.index_type == RNE_INDEX_TYPE_U32 ? sizeof(u32) : sizeof(u16);
+    u32 base_vertex = 0;
+    u32 index_offset_bytes = 0;
+    if (config.vertex_ring != NULL) {
+        config.vertex_buffer = ring_reserve(config.vertex_ring, config.vertex_capacity * sizeof(RNE_Vertex));
+        base_vertex = config.vertex_ring->offset / sizeof(RNE_Vertex);
+    }
+    if (config.index_ring != NULL) {
+        config.index_buffer = ring_reserve(config.index_ring, config.index_capacity * index_size);
+        index_offset_bytes = config.index_ring->offset;
+    }
+
+    // Texture slots come from the host and are already final.
+    b8 remap_textures = config.get_texture_slot == NULL;
+    u32 vertex_base = 0;
+    u32 index_base = 0;
+    u32 instance_base = 0;
+    RNE_RenderCmd* first = NULL;
+    RNE_RenderCmd* last = NULL;
+    // Set when the serial path would have split the render command at a
+    // scissor change since the last geometry.
+    b8 scissor_split = false;
+
+    SP_Scratch scratch = sp_scratch_begin(&config.arena, 1);
+    TextureTable textures = {0};
+    if (remap_textures) {
+        textures = texture_table_init(scratch.arena, config.texture_buffer, config.texture_capacity);
+    }
+    u32* texture_remap = sp_arena_push_no_zero(scratch.arena, sizeof(u32) * config.texture_capacity);
+    for (u32 i = 0; i < jobs->job_count; i++) {
+        TessellationJob* job = &jobs->jobs[i];
+        RNE_BatchCmd job_batch = job->batch;
+
+        // Textures are numbered in order of first use, which gives the same
+        // numbering as the serial path.
+        for (u32 j = 0; j < job_batch.texture_count; j++) {
+            i32 texture_index = texture_table_find(&textures, job->config.texture_buffer[j]);
+            if (texture_index < 0) {
+                sp_scratch_end(scratch);
+                return false;
+            }
+            texture_remap[j] = texture_index;
+        }
+
+        for (u32 j = 0; j < job_batch.vertex_count; j++) {
+            RNE_Vertex vertex = job->config.vertex_buffer[j];
+            if (remap_textures) {
+                vertex.texture_index = texture_remap[vertex.texture_index];
+            }
+            config.vertex_buffer[vertex_base + j] = vertex;
+        }
+
+        for (u32 j = 0; j < job_batch.index_count; j++) {
+            if (config.index_type == RNE_INDEX_TYPE_U32) {
+                ((u32*) config.index_buffer)[index_base + j] = ((u32*) job->config.index_buffer)[j] + vertex_base;
+            } else {
+                ((u16*) config.index_buffer)[index_base + j] = ((u16*) job->config.index_buffer)[j] + vertex_base;
+            }
+        }
+
+        for (u32 j = 0; j < job_batch.instance_count; j++) {
+            RNE_Instance instance = job->config.instance_buffer[j];
+            if (remap_textures) {
+                instance.texture_index = texture_remap[instance.texture_index];
+            }
+            config.instance_buffer[instance_base + j] = instance;
+        }
+
+        RNE_RenderCmd* job_cmd = job_batch.render_cmds;
+        if (job_cmd != NULL && last != NULL &&
+                !scissor_split && !job->state.leading_scissor_change &&
+                job_cmd->type == last->type &&
+                scissor_equal(job_cmd->scissor, last->scissor)) {
+            // The job boundary split a render command the serial path
+            // wouldn't have.
+            last->index_count += job_cmd->index_count;
+            last->instance_count += job_cmd->instance_count;
+            job_cmd = job_cmd->next;
+        }
+        for (; job_cmd != NULL; job_cmd = job_cmd->next) {
+            RNE_RenderCmd* render_cmd = sp_arena_push_no_zero(config.arena, sizeof(RNE_RenderCmd));
+            *render_cmd = *job_cmd;
+            render_cmd->next = NULL;
+            if (render_cmd->type == RNE_RENDER_CMD_TYPE_TRIANGLES) {
+                render_cmd->start_offset_bytes += index_offset_bytes + index_base * index_size;
+            } else {
+                render_cmd->first_instance += instance_base;
+            }
+            sp_sll_queue_push(first, last, render_cmd);
+        }
+
+        if (job->state.geometry_emitted) {
+            scissor_split = job->state.trailing_scissor_change;
+        } else {
+            scissor_split |= job->state.leading_scissor_change;
+        }
+
+        vertex_base += job_batch.vertex_count;
+        index_base += job_batch.index_count;
+        instance_base += job_batch.instance_count;
+    }
+    sp_scratch_end(scratch);
+
+    if (config.vertex_ring != NULL) {
+        config.vertex_ring->offset += vertex_count * sizeof(RNE_Vertex);
+    }
+    if (config.index_ring != NULL) {
+        config.index_ring->offset += index_count * index_size;
+    }
+
+    *batch = (RNE_BatchCmd) {
+        .base_vertex = base_vertex,
+        .vertex_count = vertex_count,
+        .index_count = index_count,
+        .instance_count = instance_count,
+        .texture_count = textures.count,
+        .render_cmds = first,
+    };
+    return true;
+}